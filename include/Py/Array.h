@@ -0,0 +1,181 @@
+
+#ifndef PYXX_ARRAY_H
+#define PYXX_ARRAY_H
+
+#include <Python.h>
+
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Py/Compat.h"
+#include "Py/Object.h"
+#include "Py/Extention.h"
+#include "Py/Box.h"
+#include "Py/Buffer.h"
+#include "Py/Thread.h"
+
+namespace Py {
+
+template<typename T>
+struct ArrayData
+{
+  std::vector<T> items;
+  Py_ssize_t shape[2];
+  Py_ssize_t strides[2];
+
+  size_t heap_size() const { return HeapSize<std::vector<T>>::of(items); }
+};
+
+/// Arrays hold only numbers, so big ones are freed in the background.
+template<typename T>
+struct ReclaimPolicy<ArrayData<T>> : ReclaimAbove<(16 << 20)> { };
+
+/// A fixed-size, contiguous array of `T` that exports the buffer protocol,
+/// for handing native results to Python without boxing each element.
+///
+/// Elements are described by `ItemFormat<T>`. Plain numbers export as a
+/// 1-D buffer; a struct of `width` fields exports as `(n, width)`, so
+/// `memoryview(a).tolist()` gives one row per element. Indexing boxes a
+/// single element with `Py::box`, when `T` is boxable.
+///
+/// A module that makes arrays of `T` must call `Array<T>::Ready` in its
+/// init; making one before then raises `SystemError`. Modules in one
+/// process may share the type, so only the first call readies it (and
+/// names it).
+template<typename T>
+struct Array : Extention<ArrayData<T>>
+{
+  using Format    = ItemFormat<T>;
+  using Component = typename Format::component;
+
+  static_assert(sizeof(T) == Format::width * sizeof(Component),
+                "Array elements must be packed rows of their component.");
+
+  std::vector<T>       &items()       { return this->get().items; }
+  const std::vector<T> &items() const { return this->get().items; }
+
+  T     *data()       { return items().data(); }
+  size_t size() const { return items().size(); }
+
+  static int Ready(const char *name = "pyxx.Array")
+  {
+    using Self = Array;
+    static std::mutex m;
+    std::unique_lock<std::mutex> lock = lock_detached(m);
+    if (Self::type.tp_flags & Py_TPFLAGS_READY)
+      return 0;
+
+    static PySequenceMethods seq = sequence_methods();
+    static PyBufferProcs buf = buffer_procs();
+
+    Self::type.tp_name = name;
+    Self::type.tp_as_sequence = &seq;
+    Self::type.tp_as_buffer = &buf;
+#if !PYXX_PY3
+    Self::type.tp_flags |= Py_TPFLAGS_HAVE_NEWBUFFER;
+#endif
+    return PyType_Ready(&Self::type);
+  }
+
+  /// A new array holding `v`.
+  static PyObject *make(std::vector<T> v)
+  {
+    using Self = Array;
+    if (!(Self::type.tp_flags & Py_TPFLAGS_READY)) {
+      PyErr_SetString(PyExc_SystemError, "Py::Array is not ready");
+      return nullptr;
+    }
+
+    PyObject *o = Self::type.tp_new(&Self::type, nullptr, nullptr);
+    if (!o)
+      return nullptr;
+
+    CriticalSection lock(o);  // `type_stats` may be reading it already.
+    ArrayData<T> &d = ((Array *) o)->get();
+    d.items = std::move(v);
+    d.shape[0] = d.items.size();
+    d.shape[1] = Format::width;
+    d.strides[0] = sizeof(T);
+    d.strides[1] = sizeof(Component);
+    return o;
+  }
+
+  /// A new array of `n` value-initialized elements.
+  static PyObject *make(size_t n)
+  {
+    return make(std::vector<T>(n));
+  }
+
+private:
+  static Py_ssize_t length(PyObject *self)
+  {
+    return ((Array *) self)->size();
+  }
+
+  template<typename U = T>
+  static auto item_slot(int) -> decltype(box(std::declval<const U &>()),
+                                         ssizeargfunc())
+  {
+    return [](PyObject *self, Py_ssize_t i) -> PyObject * {
+      Array *a = (Array *) self;
+      if (i < 0 || (size_t) i >= a->size()) {
+        PyErr_SetString(PyExc_IndexError, "array index out of range");
+        return nullptr;
+      }
+      return box(a->items()[i]);
+    };
+  }
+
+  template<typename U = T>
+  static std::nullptr_t item_slot(...)
+  {
+    return nullptr;
+  }
+
+  static int getbuffer(PyObject *self, Py_buffer *view, int flags)
+  {
+    ArrayData<T> &d = ((Array *) self)->get();
+
+    view->obj = self;
+    Py_INCREF(self);
+    view->buf = d.items.data();
+    view->len = d.items.size() * sizeof(T);
+    view->readonly = 0;
+    view->itemsize = sizeof(Component);
+    view->format = (flags & PyBUF_FORMAT) ? (char *) Format::code() : nullptr;
+    view->ndim = Format::width == 1 ? 1 : 2;
+    view->shape = (flags & PyBUF_ND) ? d.shape : nullptr;
+    if (!view->shape) {
+      // Without a shape, the consumer sees flat bytes.
+      view->ndim = 1;
+      if (!view->format)
+        view->itemsize = 1;
+    }
+    view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? d.strides
+                                                             : nullptr;
+    view->suboffsets = nullptr;
+    view->internal = nullptr;
+    return 0;
+  }
+
+  static PySequenceMethods sequence_methods()
+  {
+    PySequenceMethods m = { };
+    m.sq_length = length;
+    m.sq_item = item_slot(0);
+    return m;
+  }
+
+  static PyBufferProcs buffer_procs()
+  {
+    PyBufferProcs b = { };
+    b.bf_getbuffer = getbuffer;
+    return b;
+  }
+};
+
+}  // namespace py
+
+#endif  // PYXX_ARRAY_H
@@ -0,0 +1,225 @@
+
+#ifndef PYXX_ASYNC_H
+#define PYXX_ASYNC_H
+
+#include <Python.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+
+#include "Py/Object.h"
+#include "Py/Extention.h"
+#include "Py/Box.h"
+#include "Py/Thread.h"
+#include "Py/Tuple.h"
+
+namespace Py {
+
+/// The part of a task shared with the worker running it. None of it is a
+/// Python object, so the worker never needs the GIL.
+struct TaskState
+{
+  enum Status { Pending, Running, Done, Cancelled };
+
+  std::mutex mutex;
+  std::condition_variable finished;
+  Status status = Pending;
+
+  /// Set by the worker; called on the collecting thread, with the GIL, to
+  /// turn the C++ result into a Python object.
+  std::function<PyObject *()> box;
+
+  /// The message of an exception thrown by the callable.
+  std::string error;
+  bool failed = false;
+
+  template<typename F>
+  void run(F &f)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (status == Cancelled)
+        return;
+      status = Running;
+    }
+
+    try {
+      box = result_of(f, std::is_void<decltype(f())>());
+    } catch (const std::exception &e) {
+      error = e.what();
+      failed = true;
+    } catch (...) {
+      error = "unknown C++ exception";
+      failed = true;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      status = Done;
+    }
+    finished.notify_all();
+  }
+
+  template<typename F>
+  static std::function<PyObject *()> result_of(F &f, std::true_type)
+  {
+    f();
+    return [] { Py_RETURN_NONE; };
+  }
+
+  template<typename F>
+  static std::function<PyObject *()> result_of(F &f, std::false_type)
+  {
+    auto r = std::make_shared<std::decay_t<decltype(f())>>(f());
+    return [r] { return Py::box(*r); };
+  }
+};
+
+struct TaskHandle
+{
+  std::shared_ptr<TaskState> state;
+
+  /// The boxed result, once collected.
+  Object result;
+};
+
+/// The Python side of `async_call`: a handle to a C++ callable running on
+/// `ThreadPool::global()`.
+///
+/// Like `concurrent.futures.Future`, a task can only be cancelled before it
+/// starts; a running C++ callable is never interrupted.
+struct Task : Extention<TaskHandle>
+{
+  TaskState &state() { return *this->get().state; }
+
+  static int Ready(const char *name)
+  {
+    type.tp_name = name;
+    type.tp_methods = methods();
+    return PyType_Ready(&type);
+  }
+
+  /// Waits without the GIL. A negative timeout waits forever.
+  bool wait_for(double timeout)
+  {
+    std::shared_ptr<TaskState> s = this->get().state;
+    AllowThreads nogil;
+    std::unique_lock<std::mutex> lock(s->mutex);
+    auto over = [&] {
+      return s->status == TaskState::Done ||
+             s->status == TaskState::Cancelled;
+    };
+    if (timeout < 0) {
+      s->finished.wait(lock, over);
+      return true;
+    }
+    return s->finished.wait_for(lock, std::chrono::duration<double>(timeout),
+                                over);
+  }
+
+  static PyObject *done(PyObject *self, PyObject *)
+  {
+    TaskState &s = ((Task *) self)->state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return Object(s.status == TaskState::Done ||
+                  s.status == TaskState::Cancelled).release();
+  }
+
+  static PyObject *wait(PyObject *self, PyObject *args)
+  {
+    double timeout = -1;
+    Optional opt;
+    if (!ParseTuple(args, opt, timeout))
+      return nullptr;
+    return Object(((Task *) self)->wait_for(timeout)).release();
+  }
+
+  static PyObject *result(PyObject *self, PyObject *)
+  {
+    Task *task = (Task *) self;
+    task->wait_for(-1);
+
+    CriticalSection lock(self);
+    TaskHandle &h = task->get();
+    if (h.result.self)
+      return Object(h.result).release();
+
+    TaskState &s = task->state();
+    if (s.status == TaskState::Cancelled) {
+      PyErr_SetString(PyExc_RuntimeError, "task was cancelled");
+      return nullptr;
+    }
+    if (s.failed) {
+      PyErr_SetString(PyExc_RuntimeError, s.error.c_str());
+      return nullptr;
+    }
+
+    h.result.self = s.box();
+    if (!h.result.self)
+      return nullptr;
+    return Object(h.result).release();
+  }
+
+  static PyObject *cancel(PyObject *self, PyObject *)
+  {
+    TaskState &s = ((Task *) self)->state();
+    bool cancelled;
+    {
+      std::lock_guard<std::mutex> lock(s.mutex);
+      if (s.status == TaskState::Pending)
+        s.status = TaskState::Cancelled;
+      cancelled = s.status == TaskState::Cancelled;
+    }
+    s.finished.notify_all();
+    return Object(cancelled).release();
+  }
+
+  static PyMethodDef *methods()
+  {
+    static PyMethodDef defs[] = {
+      {"done", done, METH_NOARGS,
+       "True once the task has finished or was cancelled."},
+      {"wait", wait, METH_VARARGS,
+       "wait([timeout]) -> whether the task finished in time."},
+      {"result", result, METH_NOARGS,
+       "Waits for the task and returns its result."},
+      {"cancel", cancel, METH_NOARGS,
+       "Cancels the task if it has not started. Returns True if cancelled."},
+      {NULL, NULL, 0, NULL}
+    };
+    return defs;
+  }
+};
+
+/// Runs `f()` on a worker thread, without the GIL, and returns a new `Task`.
+///
+/// `f` must not touch Python objects: copy its arguments out of the Python
+/// objects first. Its result is boxed with `Py::box` by whichever thread
+/// calls `result()`. `Task::Ready` must have been called at module init.
+template<typename F>
+PyObject *async_call(F f)
+{
+  if (!(Task::type.tp_flags & Py_TPFLAGS_READY)) {
+    PyErr_SetString(PyExc_SystemError, "Py::Task is not ready");
+    return nullptr;
+  }
+
+  PyObject *o = Task::type.tp_new(&Task::type, nullptr, nullptr);
+  if (!o)
+    return nullptr;
+
+  auto s = std::make_shared<TaskState>();
+  ((Task *) o)->get().state = s;
+  ThreadPool::global().submit([s, f]() mutable { s->run(f); });
+  return o;
+}
+
+}  // namespace py
+
+#endif  // PYXX_ASYNC_H
@@ -0,0 +1,65 @@
+
+#ifndef PYXX_BOX_H
+#define PYXX_BOX_H
+
+#include <Python.h>
+
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include "Py/Object.h"
+#include "Py/List.h"
+#include "Py/Tuple.h"
+
+namespace Py {
+
+/// Values that `Object` has a constructor for.
+template<typename T>
+auto box_impl(const T &x, int) -> decltype(Object(x), (PyObject *) nullptr)
+{
+  return Object(x).release();
+}
+
+/// Anything else with a `begin()` and `end()` becomes a list.
+template<typename T>
+auto box_impl(const T &x, ...)
+  -> decltype(std::begin(x), std::end(x), (PyObject *) nullptr)
+{
+  return List(x).release();
+}
+
+/// Types whose `Converter` also knows how to box them come first.
+template<typename T>
+auto box_converted(const T &x, int)
+  -> decltype(Converter<T>::box(x), (PyObject *) nullptr)
+{
+  return Converter<T>::box(x);
+}
+
+template<typename T>
+auto box_converted(const T &x, ...) -> decltype(box_impl(x, 0))
+{
+  return box_impl(x, 0);
+}
+
+/// Converts a C++ value into a new reference, or null with an exception set.
+template<typename T>
+auto box(const T &x) -> decltype(box_converted(x, 0))
+{
+  return box_converted(x, 0);
+}
+
+/// Whether `box` accepts a `T`.
+template<typename T, typename = void>
+struct IsBoxable : std::false_type { };
+
+template<typename T>
+struct IsBoxable<T, decltype((void) box(std::declval<const T &>()))>
+  : std::true_type
+{
+};
+
+}  // namespace py
+
+#endif  // PYXX_BOX_H
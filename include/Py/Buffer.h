@@ -0,0 +1,238 @@
+
+#ifndef PYXX_BUFFER_H
+#define PYXX_BUFFER_H
+
+#include <Python.h>
+
+#include <cstring>
+#include <type_traits>
+
+#if __cplusplus >= 201703L
+# include <string_view>
+#endif
+#if __cplusplus > 201703L && __has_include(<span>)
+# include <span>
+#endif
+
+#include "Py/Compat.h"
+#include "Py/Object.h"
+#include "Py/Tuple.h"
+
+namespace Py {
+
+/// The struct-module code of `T`, for exporting buffers of it.
+///
+/// A struct of `width` identical arithmetic fields can specialize this with
+/// its field's code and `width`; `Array` then exports it as rows.
+template<typename T>
+struct ItemFormat;
+
+#define PYXX_ITEM_FORMAT(T, c)                                                 \
+  template<> struct ItemFormat<T> {                                            \
+    using component = T;                                                       \
+    static constexpr Py_ssize_t width = 1;                                     \
+    static const char *code() { return c; }                                    \
+  }
+
+PYXX_ITEM_FORMAT(bool,               "?");
+PYXX_ITEM_FORMAT(signed char,        "b");
+PYXX_ITEM_FORMAT(unsigned char,      "B");
+PYXX_ITEM_FORMAT(short,              "h");
+PYXX_ITEM_FORMAT(unsigned short,     "H");
+PYXX_ITEM_FORMAT(int,                "i");
+PYXX_ITEM_FORMAT(unsigned int,       "I");
+PYXX_ITEM_FORMAT(long,               "l");
+PYXX_ITEM_FORMAT(unsigned long,      "L");
+PYXX_ITEM_FORMAT(long long,          "q");
+PYXX_ITEM_FORMAT(unsigned long long, "Q");
+PYXX_ITEM_FORMAT(float,              "f");
+PYXX_ITEM_FORMAT(double,             "d");
+
+#undef PYXX_ITEM_FORMAT
+
+/// Whether a buffer's `format` and `itemsize` describe a `T`.
+///
+/// Only the kind (signed, unsigned or floating) is read from the format
+/// code; the size comes from `itemsize`, so `l` and `q` both match a
+/// 64-bit integer. Byte order prefixes other than native are rejected.
+template<typename T>
+bool FormatMatches(const char *fmt, Py_ssize_t itemsize)
+{
+  if (itemsize != sizeof(T))
+    return false;
+  if (!fmt)
+    fmt = "B";
+
+  const unsigned one = 1;
+  const bool little = *(const char *) &one;
+  switch (*fmt) {
+    case '@': case '=': fmt++; break;
+    case '<': if (!little && itemsize > 1) return false; fmt++; break;
+    case '>': case '!': if (little && itemsize > 1) return false; fmt++; break;
+  }
+  if (!fmt[0] || fmt[1])
+    return false;
+
+  if (std::is_floating_point<T>::value)
+    return std::strchr("efd", *fmt);
+  if (sizeof(T) == 1)
+    return std::strchr("bBc?", *fmt);
+  if (std::is_signed<T>::value)
+    return std::strchr("bhilqn", *fmt);
+  return std::strchr("BHILQN", *fmt);
+}
+
+/// A typed view of an argument's buffer, without copying it.
+///
+/// Bind it with `ParseTuple` like any other argument. The format is checked
+/// once, when the argument is parsed, and the buffer is released when the
+/// view goes out of scope, normally when the bound function returns.
+/// `View<const T>` accepts read-only buffers; `View<T>` asks for a writable
+/// one. `View<const char>` also borrows the UTF-8 of a `str`.
+///
+///   Py::View<const float> xs;
+///   if (!Py::ParseTuple(args, xs))
+///     return nullptr;
+///   float sum = std::accumulate(xs.begin(), xs.end(), 0.f);
+template<typename T>
+struct View
+{
+  using value_type = std::remove_const_t<T>;
+
+  View() noexcept { buf.obj = nullptr; }
+  ~View() noexcept { release(); }
+
+  View(const View &) = delete;
+  View &operator= (const View &) = delete;
+
+  T *data()  const noexcept { return ptr; }
+  T *begin() const noexcept { return ptr; }
+  T *end()   const noexcept { return ptr + n; }
+
+  size_t size()  const noexcept { return n; }
+  bool   empty() const noexcept { return n == 0; }
+
+  T &operator[] (size_t i) const noexcept { return ptr[i]; }
+
+#if __cplusplus >= 201703L
+  template<typename U = value_type,
+           typename = std::enable_if_t<sizeof(U) == 1>>
+  operator std::string_view() const noexcept {
+    return std::string_view((const char *) ptr, n);
+  }
+#endif
+
+#ifdef __cpp_lib_span
+  std::span<T> span() const noexcept { return std::span<T>(ptr, n); }
+  operator std::span<T>() const noexcept { return span(); }
+#endif
+
+  /// Fills the view from `o`. Returns false with an exception set if `o` has
+  /// no buffer of `T`s.
+  bool fill(PyObject *o)
+  {
+    release();
+
+#if PYXX_PY3
+    if (sizeof(T) == 1 && std::is_const<T>::value && PyUnicode_Check(o)) {
+      Py_ssize_t len;
+      const char *s = PyUnicode_AsUTF8AndSize(o, &len);
+      if (!s)
+        return false;
+      owner.self = o;
+      owner.incref();
+      ptr = (T *) s;
+      n = len;
+      return true;
+    }
+#endif
+
+    int flags = PyBUF_FORMAT | PyBUF_C_CONTIGUOUS;
+    if (!std::is_const<T>::value)
+      flags |= PyBUF_WRITABLE;
+    if (PyObject_GetBuffer(o, &buf, flags) < 0)
+      return false;
+
+    if (!FormatMatches<value_type>(buf.format, buf.itemsize)) {
+      PyErr_Format(PyExc_TypeError,
+                   "buffer of '%s' (itemsize %zd) where %zu-byte items "
+                   "were expected",
+                   buf.format ? buf.format : "B", buf.itemsize, sizeof(T));
+      release();
+      return false;
+    }
+
+    ptr = (T *) buf.buf;
+    n = buf.len / buf.itemsize;
+    return true;
+  }
+
+  void release() noexcept
+  {
+    if (buf.obj)
+      PyBuffer_Release(&buf);
+    buf.obj = nullptr;
+    owner.decref();
+    owner.self = nullptr;
+    ptr = nullptr;
+    n = 0;
+  }
+
+private:
+  Py_buffer buf;
+  Object owner;
+  T *ptr = nullptr;
+  size_t n = 0;
+};
+
+template<typename T>
+struct Converter<View<T>>
+{
+  static int convert(PyObject *o, void *v)
+  {
+    return ((View<T> *) v)->fill(o);
+  }
+};
+
+#if __cplusplus >= 201703L
+/// Borrows the contents of a `str` or `bytes` argument, which the argument
+/// tuple keeps alive, and unchanged, for the whole call. A `bytearray` can be
+/// resized by another thread (or a callback) while it is borrowed, so it,
+/// like `memoryview` or `array`, needs a `View<const char>`, which holds a
+/// buffer export that locks its size.
+template<>
+struct Converter<std::string_view>
+{
+  static int convert(PyObject *o, void *v)
+  {
+    auto *sv = (std::string_view *) v;
+#if PYXX_PY3
+    if (PyUnicode_Check(o)) {
+      Py_ssize_t len;
+      const char *s = PyUnicode_AsUTF8AndSize(o, &len);
+      if (!s)
+        return 0;
+      *sv = std::string_view(s, len);
+      return 1;
+    }
+    if (PyBytes_Check(o)) {
+      *sv = std::string_view(PyBytes_AS_STRING(o), PyBytes_GET_SIZE(o));
+      return 1;
+    }
+#else
+    if (PyString_Check(o)) {
+      *sv = std::string_view(PyString_AS_STRING(o), PyString_GET_SIZE(o));
+      return 1;
+    }
+#endif
+    PyErr_Format(PyExc_TypeError, "expected str or bytes, not %s%s",
+                 Py_TYPE(o)->tp_name,
+                 PyByteArray_Check(o) ? " (use a View<const char>)" : "");
+    return 0;
+  }
+};
+#endif
+
+}  // namespace py
+
+#endif  // PYXX_BUFFER_H
@@ -0,0 +1,234 @@
+
+#ifndef PYXX_CALLABLE_H
+#define PYXX_CALLABLE_H
+
+#include <Python.h>
+
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include "Py/Compat.h"
+#include "Py/Object.h"
+#include "Py/Box.h"
+#include "Py/Tuple.h"
+
+namespace Py {
+
+/// Reads a callback's result into `x`. Returns false with an exception set
+/// if it doesn't fit.
+inline bool Unbox(PyObject *o, bool &x)
+{
+  int t = PyObject_IsTrue(o);
+  x = t > 0;
+  return t >= 0;
+}
+
+inline bool Unbox(PyObject *o, Object &x)
+{
+  x.decref();
+  x.self = o;
+  x.incref();
+  return true;
+}
+
+template<typename T>
+bool unbox_in_range(long long v, T &x)
+{
+  if (v < (long long) std::numeric_limits<T>::min() ||
+      (v > 0 && (unsigned long long) v > std::numeric_limits<T>::max())) {
+    PyErr_SetString(PyExc_OverflowError, "callback result out of range");
+    return false;
+  }
+  x = (T) v;
+  return true;
+}
+
+template<typename T>
+auto Unbox(PyObject *o, T &x)
+  -> std::enable_if_t<std::is_integral<T>::value && std::is_signed<T>::value,
+                      bool>
+{
+  long long v = PyLong_AsLongLong(o);
+  if (v == -1 && PyErr_Occurred())
+    return false;
+  return unbox_in_range(v, x);
+}
+
+template<typename T>
+auto Unbox(PyObject *o, T &x)
+  -> std::enable_if_t<std::is_integral<T>::value && !std::is_signed<T>::value &&
+                      !std::is_same<T, bool>::value, bool>
+{
+#if !PYXX_PY3
+  if (PyInt_Check(o)) {
+    long v = PyInt_AS_LONG(o);
+    if (v < 0) {
+      PyErr_SetString(PyExc_OverflowError, "callback result out of range");
+      return false;
+    }
+    return unbox_in_range((long long) v, x);
+  }
+  if (!PyLong_Check(o)) {
+    PyErr_SetString(PyExc_TypeError, "an integer is required");
+    return false;
+  }
+#endif
+  unsigned long long v = PyLong_AsUnsignedLongLong(o);
+  if (v == (unsigned long long) -1 && PyErr_Occurred())
+    return false;
+  if (v > std::numeric_limits<T>::max()) {
+    PyErr_SetString(PyExc_OverflowError, "callback result out of range");
+    return false;
+  }
+  x = (T) v;
+  return true;
+}
+
+template<typename T>
+auto Unbox(PyObject *o, T &x)
+  -> std::enable_if_t<std::is_floating_point<T>::value, bool>
+{
+  double v = PyFloat_AsDouble(o);
+  if (v == -1 && PyErr_Occurred())
+    return false;
+  x = (T) v;
+  return true;
+}
+
+/// Everything else goes through `ParseValue`, so a `Converter` works too.
+template<typename T>
+auto Unbox(PyObject *o, T &x)
+  -> std::enable_if_t<!std::is_arithmetic<T>::value, bool>
+{
+  return ParseValue(o, x);
+}
+
+template<typename Signature>
+struct Callable;
+
+/// A Python callable to be called many times from C++ with `Args`, whose
+/// result is read back as an `R`: a predicate, a sort key, a map function.
+///
+/// Arguments are boxed with `Py::box` straight into an argument vector and
+/// passed by vectorcall, which builtins and Python functions take without
+/// building a tuple. Before Python 3.9 one argument tuple is kept and
+/// refilled for every call that didn't hold on to it, and single-argument
+/// builtins are called directly.
+///
+///   Py::Callable<bool(int)> pred(o);
+///   if (!pred.self)
+///     return nullptr;  // Not callable.
+///   bool keep;
+///   if (!pred(keep, x))
+///     return nullptr;  // The callback raised.
+template<typename R, typename...Args>
+struct Callable<R(Args...)> : Object
+{
+  static constexpr size_t arity = sizeof...(Args);
+
+  /// Checks `f` once. If it isn't callable, sets a TypeError and leaves
+  /// `self` null.
+  explicit Callable(PyObject *f) noexcept : Object(f)
+  {
+    if (self && !PyCallable_Check(self)) {
+      PyErr_Format(PyExc_TypeError, "'%s' object is not callable",
+                   Py_TYPE(self)->tp_name);
+      decref();
+      self = nullptr;
+    }
+  }
+
+  ~Callable() noexcept { Py_XDECREF(args); }
+
+  Callable(const Callable &) = delete;
+  Callable &operator= (const Callable &) = delete;
+
+  /// Calls with `xs` and reads the result into `r`. Returns false with an
+  /// exception set if boxing, the call or reading the result failed.
+  template<typename Res = R>
+  std::enable_if_t<!std::is_void<Res>::value, bool>
+  operator() (Res &r, const Args &...xs) noexcept
+  {
+    PyObject *o = call(xs...);
+    if (!o)
+      return false;
+    bool ok = Unbox(o, r);
+    Py_DECREF(o);
+    return ok;
+  }
+
+  /// Calls with `xs`, ignoring the result.
+  template<typename Res = R>
+  std::enable_if_t<std::is_void<Res>::value, bool>
+  operator() (const Args &...xs) noexcept
+  {
+    PyObject *o = call(xs...);
+    Py_XDECREF(o);
+    return o != nullptr;
+  }
+
+  /// Calls with `xs`. Returns the result as a new reference.
+  PyObject *call(const Args &...xs) noexcept
+  {
+    // One spare slot up front lets a bound method put `self` there
+    // without copying the arguments.
+    PyObject *argv[arity + 1] = { nullptr, box(xs)... };
+    bool boxed = true;
+    for (size_t i = 1; i <= arity; i++)
+      boxed = boxed && argv[i];
+    PyObject *r = boxed ? invoke(argv + 1) : nullptr;
+    for (size_t i = 1; i <= arity; i++)
+      Py_XDECREF(argv[i]);
+    return r;
+  }
+
+private:
+  PyObject *args = nullptr;  // The kept argument tuple, if any.
+
+#if PY_VERSION_HEX >= 0x03090000
+  PyObject *invoke(PyObject **argv) noexcept
+  {
+    return PyObject_Vectorcall(self, argv,
+                               arity | PY_VECTORCALL_ARGUMENTS_OFFSET,
+                               nullptr);
+  }
+#else
+  PyObject *invoke(PyObject **argv) noexcept
+  {
+    if (arity == 1 && PyCFunction_Check(self) &&
+        (PyCFunction_GET_FLAGS(self) & ~METH_COEXIST) == METH_O)
+      return PyCFunction_GET_FUNCTION(self)(PyCFunction_GET_SELF(self),
+                                            argv[0]);
+
+    // Take the kept tuple while calling, so a call made from inside the
+    // callback builds its own, and keep it again only if nothing else
+    // holds it afterwards.
+    PyObject *t = args;
+    args = nullptr;
+    if (t && Py_REFCNT(t) > 1)
+      Py_CLEAR(t);
+    if (!t && !(t = PyTuple_New(arity)))
+      return nullptr;
+    for (size_t i = 0; i < arity; i++) {
+      Py_INCREF(argv[i]);
+      PyTuple_SET_ITEM(t, i, argv[i]);
+    }
+
+    PyObject *r = PyObject_Call(self, t, nullptr);
+
+    if (!args && Py_REFCNT(t) == 1) {
+      for (size_t i = 0; i < arity; i++)
+        Py_CLEAR(PyTuple_GET_ITEM(t, i));
+      args = t;
+    } else {
+      Py_DECREF(t);
+    }
+    return r;
+  }
+#endif
+};
+
+}  // namespace py
+
+#endif  // PYXX_CALLABLE_H
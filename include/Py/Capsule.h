@@ -0,0 +1,102 @@
+
+#ifndef PYXX_CAPSULE_H
+#define PYXX_CAPSULE_H
+
+#include <Python.h>
+
+#include <atomic>
+#include <cstring>
+
+#include "Py/Compat.h"
+
+namespace Py {
+
+/// What an exported table is stamped with, so an importer compiled against
+/// another layout finds out at import rather than by crashing.
+struct ApiHeader
+{
+  unsigned version;
+  size_t size;
+};
+
+template<typename Api>
+struct ApiTable
+{
+  ApiHeader header;
+  Api api;
+};
+
+/// Publishes `api`, a table of function pointers and type objects, as a
+/// capsule named `Api::capsule` in `m`, for other extensions to call
+/// without going through Python. `Api` names its capsule and versions its
+/// layout:
+///
+///   struct VecApi {
+///     static constexpr const char *capsule = "vec._C_API";
+///     static constexpr unsigned version = 1;
+///
+///     Py::Type *vec_type;
+///     PyObject *(*make)(const Vec &);
+///   };
+///
+/// Bump `version` when a field changes; fields may be appended without one.
+/// The capsule name must be `module.attribute`. Call it from the module's
+/// exec function, once its types are ready. Returns -1 with an exception
+/// set on failure.
+template<typename Api>
+int export_api(PyObject *m, const Api &api)
+{
+  static ApiTable<Api> table;
+  table.header = ApiHeader{Api::version, sizeof(Api)};
+  table.api = api;
+
+  const char *attr = std::strrchr(Api::capsule, '.');
+  PyObject *c = PyCapsule_New(&table, Api::capsule, nullptr);
+  if (!c)
+    return -1;
+  if (PyModule_AddObject(m, attr ? attr + 1 : Api::capsule, c) < 0) {
+    Py_DECREF(c);
+    return -1;
+  }
+  return 0;
+}
+
+/// The table `export_api<Api>` published, importing its module if needed,
+/// or null with an ImportError set if it is missing or was built with
+/// another version. The first success is remembered.
+///
+///   const VecApi *vec = Py::import_api<VecApi>();
+///   if (!vec)
+///     return nullptr;
+///   if (vec->vec_type->IsSubtype(o))
+///     ...
+template<typename Api>
+const Api *import_api()
+{
+  static std::atomic<const Api *> cached{nullptr};
+  const Api *api = cached.load(std::memory_order_acquire);
+  if (api)
+    return api;
+
+  auto *table = (const ApiTable<Api> *) PyCapsule_Import(Api::capsule, 0);
+  if (!table)
+    return nullptr;
+  if (table->header.version != Api::version) {
+    PyErr_Format(PyExc_ImportError, "%s has version %u, expected %u",
+                 Api::capsule, table->header.version, Api::version);
+    return nullptr;
+  }
+  if (table->header.size < sizeof(Api)) {
+    PyErr_Format(PyExc_ImportError, "%s is %zu bytes, expected at least %zu",
+                 Api::capsule, table->header.size, sizeof(Api));
+    return nullptr;
+  }
+
+  api = &table->api;
+  cached.store(api, std::memory_order_release);
+  return api;
+}
+
+}  // namespace py
+
+#endif  // PYXX_CAPSULE_H
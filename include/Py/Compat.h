@@ -0,0 +1,145 @@
+
+#ifndef PYXX_COMPAT_H
+#define PYXX_COMPAT_H
+
+#include <Python.h>
+
+#include <mutex>
+
+/// Differences between the Python 2 and Python 3 APIs that the rest of the
+/// library would otherwise have to `#if` around at every use.
+
+#if PY_MAJOR_VERSION >= 3
+# define PYXX_PY3 1
+#else
+# define PYXX_PY3 0
+#endif
+
+namespace Py {
+
+#if PYXX_PY3
+using StringObject = PyUnicodeObject;
+
+inline PyObject *StringFromString(const char *s) {
+  return PyUnicode_FromString(s);
+}
+inline PyObject *StringFromStringAndSize(const char *s, Py_ssize_t n) {
+  return PyUnicode_FromStringAndSize(s, n);
+}
+inline bool StringCheck(PyObject *o) {
+  return PyUnicode_Check(o);
+}
+inline Py_ssize_t StringSize(PyObject *s) {
+  Py_ssize_t n = 0;
+  PyUnicode_AsUTF8AndSize(s, &n);
+  return n;
+}
+inline const char *StringAsString(PyObject *s) {
+  return PyUnicode_AsUTF8(s);
+}
+inline void StringConcat(PyObject **s, PyObject *t) {
+  PyUnicode_Append(s, t);
+}
+inline void StringConcatAndDel(PyObject **s, PyObject *t) {
+  PyUnicode_AppendAndDel(s, t);
+}
+template<typename...Args>
+PyObject *StringFromFormat(const char *fmt, Args...args) {
+  return PyUnicode_FromFormat(fmt, args...);
+}
+
+inline PyObject *IntFromLong(long x)          { return PyLong_FromLong(x); }
+inline PyObject *IntFromSize_t(size_t x)      { return PyLong_FromSize_t(x); }
+inline PyObject *IntFromSsize_t(Py_ssize_t x) { return PyLong_FromSsize_t(x); }
+#else
+using StringObject = PyStringObject;
+
+inline PyObject *StringFromString(const char *s) {
+  return PyString_FromString(s);
+}
+inline PyObject *StringFromStringAndSize(const char *s, Py_ssize_t n) {
+  return PyString_FromStringAndSize(s, n);
+}
+inline bool StringCheck(PyObject *o) {
+  return PyString_Check(o);
+}
+inline Py_ssize_t StringSize(PyObject *s) {
+  return PyString_Size(s);
+}
+inline const char *StringAsString(PyObject *s) {
+  return PyString_AsString(s);
+}
+inline void StringConcat(PyObject **s, PyObject *t) {
+  PyString_Concat(s, t);
+}
+inline void StringConcatAndDel(PyObject **s, PyObject *t) {
+  PyString_ConcatAndDel(s, t);
+}
+template<typename...Args>
+PyObject *StringFromFormat(const char *fmt, Args...args) {
+  return PyString_FromFormat(fmt, args...);
+}
+
+inline PyObject *IntFromLong(long x)          { return PyInt_FromLong(x); }
+inline PyObject *IntFromSize_t(size_t x)      { return PyInt_FromSize_t(x); }
+inline PyObject *IntFromSsize_t(Py_ssize_t x) { return PyInt_FromSsize_t(x); }
+#endif
+
+/// Locks `o` for the enclosing scope on the free-threaded build, where the
+/// GIL no longer keeps two threads from mutating the same `Extention<T>`.
+/// Elsewhere it compiles to nothing.
+struct CriticalSection
+{
+#ifdef Py_GIL_DISABLED
+  PyCriticalSection cs;
+
+  explicit CriticalSection(PyObject *o) { PyCriticalSection_Begin(&cs, o); }
+  ~CriticalSection() { PyCriticalSection_End(&cs); }
+#else
+  explicit CriticalSection(PyObject *) { }
+#endif
+
+  CriticalSection(const CriticalSection &) = delete;
+  CriticalSection &operator= (const CriticalSection &) = delete;
+};
+
+/// Locks two objects at once, without risking lock-order deadlocks.
+struct CriticalSection2
+{
+#ifdef Py_GIL_DISABLED
+  PyCriticalSection2 cs;
+
+  CriticalSection2(PyObject *a, PyObject *b) {
+    PyCriticalSection2_Begin(&cs, a, b);
+  }
+  ~CriticalSection2() { PyCriticalSection2_End(&cs); }
+#else
+  CriticalSection2(PyObject *, PyObject *) { }
+#endif
+
+  CriticalSection2(const CriticalSection2 &) = delete;
+  CriticalSection2 &operator= (const CriticalSection2 &) = delete;
+};
+
+/// A mutex for threads attached to the interpreter, usable with
+/// `std::lock_guard`. On the free-threaded build it is a `PyMutex`, which
+/// detaches while it waits, so a holder may take critical sections without
+/// deadlocking. Elsewhere the GIL already serializes those threads.
+struct AttachedMutex
+{
+#ifdef Py_GIL_DISABLED
+  PyMutex m = { };
+
+  void lock() { PyMutex_Lock(&m); }
+  void unlock() { PyMutex_Unlock(&m); }
+#else
+  std::mutex m;
+
+  void lock() { m.lock(); }
+  void unlock() { m.unlock(); }
+#endif
+};
+
+}  // namespace py
+
+#endif  // PYXX_COMPAT_H
@@ -4,7 +4,19 @@
 
 #include <Python.h>
 
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
 #include "Py/Object.h"
+#include "Py/Box.h"
+#include "Py/Tuple.h"
+#include "Py/Memory.h"
+#include "Py/Reclaim.h"
+#include "Py/Trace.h"
 
 namespace Py {
 
@@ -49,7 +61,10 @@ struct Extention : PyObject
   static PyObject *make(T x) noexcept
   {
     PyObject *o = type.tp_new(&type, nullptr, nullptr);
-    if (o) new (((Extention *)o)->ptr()) T(std::move(x));
+    if (o) {
+      CriticalSection lock(o);  // `type_stats` may be reading it already.
+      new (((Extention *)o)->ptr()) T(std::move(x));
+    }
     return o;
   }
 
@@ -58,6 +73,188 @@ struct Extention : PyObject
   operator const T& () const { return get(); }
 };
 
+template<typename T>
+size_t object_heap_size(PyObject *o)
+{
+  return heap_size(((Extention<T> *) o)->get());
+}
+
+/// The counts of `Extention<T>`, reported by `type_stats`.
+template<typename T>
+TypeStats &stats_of()
+{
+  static TypeStats *s = TypeStats::add(
+    &Extention<T>::type, owns_heap<T>() ? object_heap_size<T> : nullptr);
+  return *s;
+}
+
+/// The signature of `T::operator()`, when `T` has exactly one.
+template<typename M>
+struct CallSignature : std::false_type { };
+
+template<typename T, typename R, typename...A>
+struct CallSignature<R (T::*)(A...)> : std::true_type
+{
+  using Result = R;
+  using Args = std::tuple<std::decay_t<A>...>;
+};
+
+template<typename T, typename R, typename...A>
+struct CallSignature<R (T::*)(A...) const> : CallSignature<R (T::*)(A...)>
+{
+};
+
+template<typename Args>
+struct AllParsable;
+
+template<typename...A>
+struct AllParsable<std::tuple<A...>>
+  : std::is_same<std::integer_sequence<bool, IsParsable<A>::value...>,
+                 std::integer_sequence<bool, (sizeof(A), true)...>>
+{
+};
+
+/// Whether Python can call an `Extention<T>`: `T` has one `operator()`,
+/// `ParseValue` reads each of its arguments, and its result is boxable or
+/// void.
+template<typename T, typename = void>
+struct IsCallable : std::false_type { };
+
+template<typename T>
+struct IsCallable<T, std::enable_if_t<
+  CallSignature<decltype(&T::operator())>::value>>
+  : std::integral_constant<bool,
+      AllParsable<typename CallSignature<
+        decltype(&T::operator())>::Args>::value &&
+      (std::is_void<typename CallSignature<
+         decltype(&T::operator())>::Result>::value ||
+       IsBoxable<std::decay_t<typename CallSignature<
+         decltype(&T::operator())>::Result>>::value)>
+{
+};
+
+/// `tp_call`, and the vectorcall function where the interpreter has the
+/// protocol, made from `T::operator()`. Arguments are positional only and
+/// parsed straight from the caller's array; the call holds the object's
+/// lock.
+template<typename T>
+struct CallSlot
+{
+  using Sig = CallSignature<decltype(&T::operator())>;
+  using R = typename Sig::Result;
+  using Args = typename Sig::Args;
+  using Indices = std::make_index_sequence<std::tuple_size<Args>::value>;
+
+  static constexpr Py_ssize_t arity = std::tuple_size<Args>::value;
+
+  static PyObject *call(PyObject *self, PyObject *args, PyObject *kwds)
+  {
+    if (kwds && PyDict_Size(kwds))
+      return no_keywords(self);
+    return call_with(self, ((PyTupleObject *) args)->ob_item,
+                     PyTuple_GET_SIZE(args));
+  }
+
+#ifdef Py_TPFLAGS_HAVE_VECTORCALL
+  static PyObject *vectorcall(PyObject *self, PyObject *const *args,
+                              size_t nargsf, PyObject *kwnames)
+  {
+    if (kwnames && PyTuple_GET_SIZE(kwnames))
+      return no_keywords(self);
+    return call_with(self, args, PyVectorcall_NARGS(nargsf));
+  }
+#endif
+
+private:
+  static PyObject *no_keywords(PyObject *self)
+  {
+    PyErr_Format(PyExc_TypeError, "%s() takes no keyword arguments",
+                 Py_TYPE(self)->tp_name);
+    return nullptr;
+  }
+
+  static PyObject *call_with(PyObject *self, PyObject *const *args,
+                             Py_ssize_t n)
+  {
+    if (n != arity) {
+      PyErr_Format(PyExc_TypeError, "%s() takes %d arguments (%zd given)",
+                   Py_TYPE(self)->tp_name, (int) arity, n);
+      return nullptr;
+    }
+    Args xs;
+    if (!parse(args, xs, Indices()))
+      return nullptr;
+    CriticalSection lock(self);
+    return invoke(((Extention<T> *) self)->get(), xs, std::is_void<R>());
+  }
+
+  template<size_t...Is>
+  static bool parse(PyObject *const *args, Args &xs,
+                    std::index_sequence<Is...>)
+  {
+    bool ok = true;
+    (void) std::initializer_list<int>{
+      (ok = ok && ParseValue(args[Is], std::get<Is>(xs)), 0)...
+    };
+    (void) args;
+    return ok;
+  }
+
+  static PyObject *invoke(T &f, Args &xs, std::true_type)
+  {
+    apply_tuple(f, xs, Indices());
+    Py_RETURN_NONE;
+  }
+
+  static PyObject *invoke(T &f, Args &xs, std::false_type)
+  {
+    return box(apply_tuple(f, xs, Indices()));
+  }
+};
+
+/// Where a callable `Extention<T>` keeps its vectorcall function: just past
+/// the `Extention<T>` itself.
+template<typename T>
+constexpr Py_ssize_t vectorcall_offset()
+{
+  return (sizeof(Extention<T>) + sizeof(void *) - 1) / sizeof(void *) *
+         sizeof(void *);
+}
+
+template<typename T>
+void install_call(PyTypeObject &ty, std::true_type)
+{
+  ty.tp_call = CallSlot<T>::call;
+#ifdef Py_TPFLAGS_HAVE_VECTORCALL
+  ty.tp_basicsize = vectorcall_offset<T>() + sizeof(vectorcallfunc);
+  ty.tp_vectorcall_offset = vectorcall_offset<T>();
+  ty.tp_flags |= Py_TPFLAGS_HAVE_VECTORCALL;
+#endif
+}
+
+template<typename T>
+void install_call(PyTypeObject &, std::false_type) { }
+
+/// Points a new object at its vectorcall function. Objects made by some
+/// other `tp_new` are left null, which makes Python use `tp_call`.
+template<typename T>
+void init_vectorcall(PyObject *self, std::true_type)
+{
+#ifdef Py_TPFLAGS_HAVE_VECTORCALL
+  *(vectorcallfunc *) ((char *) self + vectorcall_offset<T>()) =
+    CallSlot<T>::vectorcall;
+#endif
+  (void) self;
+}
+
+template<typename T>
+void init_vectorcall(PyObject *, std::false_type) { }
+
+template<typename T>
+void default_dealloc(PyObject *self);
+
+/// Objects are tracked for `type_stats` only when `default_dealloc` will
+/// untrack them.
 template<typename T,
          typename = std::enable_if_t<std::is_default_constructible<T>::value>>
 newfunc default_new()
@@ -65,9 +262,14 @@ newfunc default_new()
   return [](PyTypeObject *type, PyObject *args, PyObject *kwds)
   {
     using Self = Extention<T>;
+    TraceScope trace("__new__", type->tp_name);
     Self *self = (Self *) type->tp_alloc(type, 0);
-    if (self)
+    if (self) {
       new (self->ptr()) T();
+      init_vectorcall<T>(self, IsCallable<T>());
+      if (type->tp_dealloc == default_dealloc<T>)
+        stats_of<T>().track(self);
+    }
     return (PyObject *) self;
   };
 }
@@ -77,55 +279,138 @@ template<typename T,
 auto default_new() {
   return [](PyTypeObject *type, PyObject *args, PyObject *kwds)
   {
-    return type->tp_alloc(type, 0);
+    TraceScope trace("__new__", type->tp_name);
+    PyObject *self = type->tp_alloc(type, 0);
+    if (self)
+      init_vectorcall<T>(self, IsCallable<T>());
+    return self;
   };
 }
 
+/// The alignment `PyObject_Malloc` guarantees.
+constexpr size_t object_alignment = PYXX_PY3 && sizeof(void *) > 4 ? 16 : 8;
+
+/// Whether an `Extention<T>` needs more alignment than the default
+/// `tp_alloc` gives, like an `alignas(32)` SIMD type.
 template<typename T>
-Type Extention<T>::type((PyTypeObject) {
-  PyObject_HEAD_INIT(NULL)
-  0,                         // ob_size
-  0,                         // tp_name
-  sizeof(Extention<T>),      // tp_basicsize
-  0,                         // tp_itemsize
-  destructor([](PyObject *self) {
-    ((Extention *) self)->get().T::~T();
-    self->ob_type->tp_free(self);
-  }),
-  0,                         // tp_print
-  0,                         // tp_getattr
-  0,                         // tp_setattr
-  0,                         // tp_compare
-  0,                         // tp_repr
-  0,                         // tp_as_number
-  0,                         // tp_as_sequence
-  0,                         // tp_as_mapping
-  0,                         // tp_hash 
-  0,                         // tp_call
-  0,                         // tp_str
-  0,                         // tp_getattro
-  0,                         // tp_setattro
-  0,                         // tp_as_buffer
-  Py_TPFLAGS_DEFAULT,        // tp_flags
-  0,                         // tp_doc 
-  0,                         // tp_traverse 
-  0,  	                     // tp_clear 
-  0,  	                     // tp_richcompare 
-  0,  	                     // tp_weaklistoffset 
-  0,  	                     // tp_iter 
-  0,  	                     // tp_iternext 
-  0,                         // tp_methods 
-  0,                         // tp_members 
-  0,                         // tp_getset 
-  0,                         // tp_base 
-  0,                         // tp_dict 
-  0,                         // tp_descr_get 
-  0,                         // tp_descr_set 
-  0,                         // tp_dictoffset 
-  0,                         // tp_init 
-  0,                         // tp_alloc 
-  default_new<T>(),          // tp_new
-});
+constexpr bool is_over_aligned()
+{
+  return alignof(Extention<T>) > object_alignment;
+}
+
+/// `tp_alloc` and `tp_free` for over-aligned types. The block is padded so
+/// the object can start on an `alignof(Extention<T>)` boundary, with the
+/// pointer to free stored in the word just before it.
+template<typename T>
+PyObject *aligned_alloc(PyTypeObject *type, Py_ssize_t)
+{
+  constexpr size_t align = alignof(Extention<T>);
+  size_t size = type->tp_basicsize;
+  char *raw = (char *) PyObject_Malloc(size + align + sizeof(void *));
+  if (!raw)
+    return PyErr_NoMemory();
+
+  uintptr_t start = (uintptr_t) (raw + sizeof(void *));
+  char *o = raw + sizeof(void *) + (align - start % align) % align;
+  ((void **) o)[-1] = raw;
+  std::memset(o, 0, size);
+  return PyObject_Init((PyObject *) o, type);
+}
+
+inline void aligned_free(void *o)
+{
+  PyObject_Free(((void **) o)[-1]);
+}
+
+template<typename T>
+void counted_free(void *o);
+
+/// `tp_alloc` and `tp_free` for `Extention<T>`, which keep the live and
+/// created counts. Each counts only while the type uses both, so a type
+/// that replaces one of them (or a subtype) can't unbalance the counts.
+template<typename T>
+PyObject *counted_alloc(PyTypeObject *type, Py_ssize_t n)
+{
+  PyObject *o = is_over_aligned<T>() ? aligned_alloc<T>(type, n)
+                                     : PyType_GenericAlloc(type, n);
+  if (o && type->tp_free == counted_free<T>)
+    stats_of<T>().allocated();
+  return o;
+}
+
+template<typename T>
+void counted_free(void *o)
+{
+  PyTypeObject *type = Py_TYPE((PyObject *) o);
+  if (type->tp_alloc == counted_alloc<T>)
+    stats_of<T>().freed();
+
+  if (is_over_aligned<T>())
+    aligned_free(o);
+  else if (PyType_IS_GC(type))
+    PyObject_GC_Del(o);
+  else
+    PyObject_Free(o);
+}
+
+/// `__sizeof__` for an `Extention<T>`: the object itself, plus the heap
+/// bytes `Py::HeapSize<T>` counts.
+template<typename T>
+PyObject *sizeof_method(PyObject *self, PyObject *)
+{
+  CriticalSection lock(self);
+  return IntFromSize_t(Py_TYPE(self)->tp_basicsize +
+                       heap_size(((Extention<T> *) self)->get()));
+}
+
+/// The `__sizeof__` entry, for types that set their own `tp_methods`.
+template<typename T>
+constexpr PyMethodDef SizeofMethod()
+{
+  return {"__sizeof__", sizeof_method<T>, METH_NOARGS,
+          "Size of the object and what it owns, in bytes."};
+}
+
+template<typename T>
+PyMethodDef *default_methods()
+{
+  static PyMethodDef defs[] = { SizeofMethod<T>(), {NULL, NULL, 0, NULL} };
+  return defs;
+}
+
+/// The default `tp_dealloc`: destroys the `T`, or hands it to the
+/// reclaimer, then frees the object.
+template<typename T>
+void default_dealloc(PyObject *self)
+{
+  TraceScope trace("__del__", Py_TYPE(self)->tp_name);
+  stats_of<T>().untrack(self);
+  destroy_value(((Extention<T> *) self)->get());
+  Py_TYPE(self)->tp_free(self);
+}
+
+/// The type every `Extention<T>` starts with. Modules fill in the name and
+/// slots from their init function, before `PyType_Ready`, and the type is
+/// never written to after that, so sharing it between threads is safe.
+template<typename T>
+PyTypeObject default_type()
+{
+  PyTypeObject ty = { PyVarObject_HEAD_INIT(NULL, 0) };
+  ty.tp_basicsize = sizeof(Extention<T>);
+  ty.tp_dealloc = default_dealloc<T>;
+  ty.tp_flags = Py_TPFLAGS_DEFAULT;
+  ty.tp_new = default_new<T>();
+  ty.tp_methods = default_methods<T>();
+  install_call<T>(ty, IsCallable<T>());
+  // Over-aligned types can't be subclassed from Python, since a subtype's
+  // allocator would not know about the padding.
+  ty.tp_alloc = counted_alloc<T>;
+  ty.tp_free = counted_free<T>;
+  return ty;
+}
+
+template<typename T>
+Type Extention<T>::type(default_type<T>());
 
 template<typename T>
 struct NumExtention : Extention<T>
@@ -137,7 +422,8 @@ struct NumExtention : Extention<T>
 ///
 /// The default for when the type has the operator, `sym`bol, uses `int` and
 /// `...` for otherwise, so the `int` version is always preferred, when
-/// available.
+/// available. Either operand may be of another type (Python calls `a + b`
+/// through `b`'s slot too), so those return `NotImplemented`.
 #define DEFAULT_BIN(sym, op)                                                   \
   template<typename T,                                                         \
            typename = std::enable_if_t<                                        \
@@ -147,8 +433,13 @@ struct NumExtention : Extention<T>
            >                                                                   \
   auto default_##op(int)                                                       \
   {                                                                            \
-    return [](PyObject *a, PyObject *b) {                                      \
+    return [](PyObject *a, PyObject *b) -> PyObject * {                        \
       using Num = NumExtention<T>;                                             \
+      if (!Num::type.IsSubtype(a) || !Num::type.IsSubtype(b)) {                \
+        Py_INCREF(Py_NotImplemented);                                          \
+        return Py_NotImplemented;                                              \
+      }                                                                        \
+      CriticalSection2 lock(a, b);                                             \
       return Num::make(((Num *) a)->get() sym ((Num *) b)->get());             \
     };                                                                         \
   }                                                                            \
@@ -164,6 +455,11 @@ struct NumExtention : Extention<T>
   {                                                                            \
     return [](PyObject *a, PyObject *b) -> PyObject * {                        \
       using Num = NumExtention<T>;                                             \
+      if (!Num::type.IsSubtype(a) || !Num::type.IsSubtype(b)) {                \
+        Py_INCREF(Py_NotImplemented);                                          \
+        return Py_NotImplemented;                                              \
+      }                                                                        \
+      CriticalSection2 lock(a, b);                                             \
       return Object(((Num *) a)->get() sym ((Num *) b)->get());                \
     };                                                                         \
   }                                                                            \
@@ -177,11 +473,17 @@ struct NumExtention : Extention<T>
 #define DEFAULT_IBIN(sym, op)                                                  \
   template<typename T>                                                         \
   auto default_##op(int)                                                       \
-   -> decltype(std::declval<T>() sym std::declval<T>(), binaryfunc())          \
+   -> decltype(std::declval<T &>() sym std::declval<T>(), binaryfunc())        \
   {                                                                            \
-    return [](PyObject *a, PyObject *b) {                                      \
+    return [](PyObject *a, PyObject *b) -> PyObject * {                        \
       using Num = NumExtention<T>;                                             \
+      if (!Num::type.IsSubtype(a) || !Num::type.IsSubtype(b)) {                \
+        Py_INCREF(Py_NotImplemented);                                          \
+        return Py_NotImplemented;                                              \
+      }                                                                        \
+      CriticalSection2 lock(a, b);                                             \
       ((Num *) a)->get() sym ((Num *) b)->get();                               \
+      Py_INCREF(a);                                                            \
       return a;                                                                \
     };                                                                         \
   }                                                                            \
@@ -199,6 +501,7 @@ struct NumExtention : Extention<T>
   {                                                                            \
     return [](PyObject *o) {                                                   \
       using Num = NumExtention<T>;                                             \
+      CriticalSection lock(o);                                                 \
       return Num::make(sym ((Num *) o)->get());                                \
     };                                                                         \
   }                                                                            \
@@ -214,6 +517,7 @@ auto default_conversion(int)
 {
   return [](PyObject *o) -> PyObject * {
     using Num = NumExtention<T>;
+    CriticalSection lock(o);
     return Object(static_cast<U>(((Num *) o)->get()));
   };
 }
@@ -223,6 +527,22 @@ std::nullptr_t default_conversion(...) {
   return nullptr;
 }
 
+template<typename T>
+auto default_bool(int)
+  -> decltype(static_cast<bool>(std::declval<T>()), inquiry())
+{
+  return [](PyObject *o) -> int {
+    using Num = NumExtention<T>;
+    CriticalSection lock(o);
+    return static_cast<bool>(((Num *) o)->get());
+  };
+}
+
+template<typename T>
+std::nullptr_t default_bool(...) {
+  return nullptr;
+}
+
 
 DEFAULT_BIN(+,  plus);
 DEFAULT_BIN(-,  subtract);
@@ -257,50 +577,50 @@ DEFAULT_UNARY(~, invert);
 // TODO: Logical operators.
 
 template<typename T>
-PyNumberMethods NumExtention<T>::numMethods = {
-  default_plus<T>(0),         // nb_add
-  default_subtract<T>(0),     // nb_subtract
-  default_multiply<T>(0),     // nb_multiply;
-  default_divide<T>(0),       // nb_divide;
-  default_modulus<T>(0),      // nb_remainder;
-  nullptr,                    // nb_divmod;
-  nullptr,                    // nb_power;
-  default_negative<T>(0),     // nb_negative;
-  default_positive<T>(0),     // nb_positive;
-  nullptr,                    // nb_absolute;
-  default_conversion<T, bool>(0),  // nb_nonzero;
-  default_invert<T>(0),       // nb_invert;
-  default_lshift<T>(0),       // nb_lshift;
-  default_rshift<T>(0),       // nb_rshift;
-  default_and<T>(0),          // nb_and;
-  default_xor<T>(0),          // nb_xor;
-  default_or<T>(0),           // nb_or;
-  nullptr,                    // nb_coerce;
-  default_conversion<T, long>(0),       // nb_int;
-  default_conversion<T, long long>(0),  // nb_long;
-  default_conversion<T, double>(0),     // nb_float;
-  nullptr,                    // nb_oct;
-  nullptr,                    // nb_hex;
-
-  default_iadd<T>(0),         // nb_inplace_add;
-  default_isubtract<T>(0),    // nb_inplace_subtract;
-  default_imultiply<T>(0),    // nb_inplace_multiply;
-  default_idivide<T>(0),      // nb_inplace_divide;
-  default_imodulus<T>(0),     // nb_inplace_remainder;
-  nullptr,                    // nb_inplace_power;
-  default_ilshift<T>(0),      // nb_inplace_lshift;
-  default_irshift<T>(0),      // nb_inplace_rshift;
-  default_iand<T>(0),         // nb_inplace_and;
-  default_ixor<T>(0),         // nb_inplace_xor;
-  default_ior<T>(0),          // nb_inplace_or;
-
-  nullptr,                    // nb_floor_divide;
-  nullptr,                    // nb_true_divide;
-  nullptr,                    // nb_inplace_floor_divide;
-  nullptr,                    // nb_inplace_true_divide;
-
-  nullptr                     // nb_index;
-};
+PyNumberMethods default_number_methods()
+{
+  PyNumberMethods m = { };
+  m.nb_add       = default_plus<T>(0);
+  m.nb_subtract  = default_subtract<T>(0);
+  m.nb_multiply  = default_multiply<T>(0);
+  m.nb_remainder = default_modulus<T>(0);
+  m.nb_negative  = default_negative<T>(0);
+  m.nb_positive  = default_positive<T>(0);
+  m.nb_invert    = default_invert<T>(0);
+  m.nb_lshift    = default_lshift<T>(0);
+  m.nb_rshift    = default_rshift<T>(0);
+  m.nb_and       = default_and<T>(0);
+  m.nb_xor       = default_xor<T>(0);
+  m.nb_or        = default_or<T>(0);
+  m.nb_int       = default_conversion<T, long>(0);
+  m.nb_float     = default_conversion<T, double>(0);
+
+  m.nb_inplace_add       = default_iadd<T>(0);
+  m.nb_inplace_subtract  = default_isubtract<T>(0);
+  m.nb_inplace_multiply  = default_imultiply<T>(0);
+  m.nb_inplace_remainder = default_imodulus<T>(0);
+  m.nb_inplace_lshift    = default_ilshift<T>(0);
+  m.nb_inplace_rshift    = default_irshift<T>(0);
+  m.nb_inplace_and       = default_iand<T>(0);
+  m.nb_inplace_xor       = default_ixor<T>(0);
+  m.nb_inplace_or        = default_ior<T>(0);
+
+#if PYXX_PY3
+  m.nb_bool                = default_bool<T>(0);
+  m.nb_true_divide         = default_divide<T>(0);
+  m.nb_inplace_true_divide = default_idivide<T>(0);
+#else
+  m.nb_nonzero        = default_bool<T>(0);
+  m.nb_long           = default_conversion<T, long long>(0);
+  m.nb_divide         = default_divide<T>(0);
+  m.nb_inplace_divide = default_idivide<T>(0);
+#endif
+
+  return m;
+}
+
+template<typename T>
+PyNumberMethods NumExtention<T>::numMethods = default_number_methods<T>();
 
 }  // namespace py
 
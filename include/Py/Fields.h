@@ -0,0 +1,180 @@
+
+#ifndef PYXX_FIELDS_H
+#define PYXX_FIELDS_H
+
+#include <Python.h>
+#include <structmember.h>
+
+#include <initializer_list>
+#include <type_traits>
+#include <vector>
+
+#include "Py/Compat.h"
+#include "Py/Object.h"
+#include "Py/Extention.h"
+#include "Py/Box.h"
+#include "Py/Tuple.h"
+
+namespace Py {
+
+/// The `structmember.h` code of a field of type `M`, or -1 if Python has no
+/// member descriptor for it.
+template<typename M>
+struct MemberType : std::integral_constant<int, -1> { };
+
+#define PYXX_MEMBER_TYPE(M, code)                                              \
+  template<> struct MemberType<M> : std::integral_constant<int, code> { }
+
+PYXX_MEMBER_TYPE(bool,               T_BOOL);
+PYXX_MEMBER_TYPE(signed char,        T_BYTE);
+PYXX_MEMBER_TYPE(unsigned char,      T_UBYTE);
+PYXX_MEMBER_TYPE(short,              T_SHORT);
+PYXX_MEMBER_TYPE(unsigned short,     T_USHORT);
+PYXX_MEMBER_TYPE(int,                T_INT);
+PYXX_MEMBER_TYPE(unsigned int,       T_UINT);
+PYXX_MEMBER_TYPE(long,               T_LONG);
+PYXX_MEMBER_TYPE(unsigned long,      T_ULONG);
+PYXX_MEMBER_TYPE(long long,          T_LONGLONG);
+PYXX_MEMBER_TYPE(unsigned long long, T_ULONGLONG);
+PYXX_MEMBER_TYPE(float,              T_FLOAT);
+PYXX_MEMBER_TYPE(double,             T_DOUBLE);
+
+#undef PYXX_MEMBER_TYPE
+
+/// A field, `p`, of `T`, exposed as the attribute `name`. Make one with
+/// `PYXX_FIELD(T, m[, doc])` or `PYXX_READONLY_FIELD(T, m[, doc])`.
+template<typename T, typename M, M T::*p, bool ReadOnly>
+struct Field
+{
+  const char *name;
+  const char *doc = nullptr;
+};
+
+#define PYXX_FIELD2(T, m)                                                      \
+  ::Py::Field<T, decltype(T::m), &T::m, false>{#m}
+#define PYXX_FIELD3(T, m, doc)                                                 \
+  ::Py::Field<T, decltype(T::m), &T::m, false>{#m, doc}
+#define PYXX_READONLY_FIELD2(T, m)                                             \
+  ::Py::Field<T, decltype(T::m), &T::m, true>{#m}
+#define PYXX_READONLY_FIELD3(T, m, doc)                                        \
+  ::Py::Field<T, decltype(T::m), &T::m, true>{#m, doc}
+
+// Picks the macro for 2 or 3 arguments in portable C++ (no GNU `##`). The
+// extra expansion is for MSVC, which passes `__VA_ARGS__` on as one token.
+#define PYXX_EXPAND(x) x
+#define PYXX_SELECT3(_1, _2, _3, name, ...) name
+
+#define PYXX_FIELD(...)                                                        \
+  PYXX_EXPAND(PYXX_SELECT3(__VA_ARGS__, PYXX_FIELD3, PYXX_FIELD2, )            \
+                (__VA_ARGS__))
+#define PYXX_READONLY_FIELD(...)                                               \
+  PYXX_EXPAND(PYXX_SELECT3(__VA_ARGS__, PYXX_READONLY_FIELD3,                  \
+                           PYXX_READONLY_FIELD2, )(__VA_ARGS__))
+
+template<typename T, typename M, M T::*p, bool ReadOnly>
+M field_type(Field<T, M, p, ReadOnly>);
+
+/// The byte offset of `ext.*p` within an `Extention<T>`.
+template<typename T, typename M>
+Py_ssize_t field_offset(M T::*p)
+{
+  alignas(Extention<T>) static char storage[sizeof(Extention<T>)];
+  auto *e = (Extention<T> *) storage;
+  return (char *) &(e->ext.*p) - storage;
+}
+
+/// Getters and setters for fields without a member descriptor. The value is
+/// boxed with `Py::box` and parsed back with `ParseValue`, holding the
+/// object's lock on the free-threaded build.
+template<typename T, typename M, M T::*p>
+struct FieldAccess
+{
+  static PyObject *get(PyObject *self, void *)
+  {
+    CriticalSection lock(self);
+    return box(((Extention<T> *) self)->get().*p);
+  }
+
+  static int set(PyObject *self, PyObject *value, void *)
+  {
+    static_assert(IsParsable<M>::value,
+                  "Fields that ParseValue can't read must be read-only.");
+    if (!value) {
+      PyErr_SetString(PyExc_TypeError, "can't delete a C++ field");
+      return -1;
+    }
+    M m;
+    if (!ParseValue(value, m))
+      return -1;
+    CriticalSection lock(self);
+    ((Extention<T> *) self)->get().*p = std::move(m);
+    return 0;
+  }
+};
+
+template<typename T>
+struct FieldDefs
+{
+  std::vector<PyMemberDef> members;
+  std::vector<PyGetSetDef> getset;
+
+  template<typename M, M T::*p, bool ReadOnly>
+  void add(Field<T, M, p, ReadOnly> f, std::true_type)
+  {
+    PyMemberDef d = { };
+    d.name = (char *) f.name;
+    d.type = MemberType<M>::value;
+    d.offset = field_offset(p);
+    d.flags = ReadOnly ? READONLY : 0;
+    d.doc = (char *) f.doc;
+    members.push_back(d);
+  }
+
+  template<typename M, M T::*p, bool ReadOnly>
+  void add(Field<T, M, p, ReadOnly> f, std::false_type)
+  {
+    PyGetSetDef d = { };
+    d.name = (char *) f.name;
+    d.get = FieldAccess<T, M, p>::get;
+    d.set = setter_of<M, p>(std::integral_constant<bool, ReadOnly>());
+    d.doc = (char *) f.doc;
+    getset.push_back(d);
+  }
+
+  template<typename M, M T::*p>
+  static setter setter_of(std::false_type)
+  {
+    return FieldAccess<T, M, p>::set;
+  }
+
+  template<typename M, M T::*p>
+  static std::nullptr_t setter_of(std::true_type) { return nullptr; }
+};
+
+/// Fills in `type`'s `tp_members` and `tp_getset` from a list of fields of
+/// `T`. Arithmetic fields become member descriptors, which read `ext`
+/// directly; anything else goes through `Py::box` and `ParseValue`. Call it
+/// once per type, before `PyType_Ready`.
+///
+///   Py::Fields<Vec>(PyVec::type, PYXX_FIELD(Vec, x), PYXX_FIELD(Vec, y),
+///                   PYXX_READONLY_FIELD(Vec, z, "The height."));
+template<typename T, typename...Fs>
+void Fields(PyTypeObject &type, Fs...fs)
+{
+  static FieldDefs<T> defs;
+  if (defs.members.empty()) {
+    (void) std::initializer_list<int>{
+      (defs.add(fs, std::integral_constant<bool,
+                      MemberType<decltype(field_type(fs))>::value >= 0>()),
+       0)...
+    };
+    defs.members.push_back(PyMemberDef{ });
+    defs.getset.push_back(PyGetSetDef{ });
+  }
+  type.tp_members = defs.members.data();
+  type.tp_getset = defs.getset.data();
+}
+
+}  // namespace py
+
+#endif  // PYXX_FIELDS_H
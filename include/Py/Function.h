@@ -0,0 +1,107 @@
+
+#ifndef PYXX_FUNCTION_H
+#define PYXX_FUNCTION_H
+
+#include <Python.h>
+
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "Py/Object.h"
+#include "Py/Extention.h"
+#include "Py/Box.h"
+#include "Py/Tuple.h"
+
+namespace Py {
+
+/// Parses `args` straight into the elements of `xs`.
+template<typename...Xs, size_t...Is>
+bool ParseTuple(PyObject *args, std::tuple<Xs...> &xs,
+                std::index_sequence<Is...>)
+{
+  return ParseTuple(args, std::get<Is>(xs)...);
+}
+
+/// Lets the value inside an `Extention<T>` be a `Bound` function's argument
+/// or result. Opt a type in with
+///
+///   template<> struct Py::Converter<Vec> : Py::ExtentionConverter<Vec> { };
+template<typename T>
+struct ExtentionConverter
+{
+  static int convert(PyObject *o, void *x)
+  {
+    using Ext = Extention<T>;
+    if (!Ext::type.IsSubtype(o)) {
+      PyErr_Format(PyExc_TypeError, "expected %s, not %s",
+                   Ext::type.tp_name, Py_TYPE(o)->tp_name);
+      return 0;
+    }
+    CriticalSection lock(o);
+    *(T *) x = ((Ext *) o)->get();
+    return 1;
+  }
+
+  static PyObject *box(const T &x)
+  {
+    return Extention<T>::make(x);
+  }
+};
+
+/// Wraps a plain C++ function, `R f(A...)`, as a `PyCFunction`.
+///
+/// Arguments are parsed with `ParseTuple` and the result is boxed with
+/// `Py::box`, so each `A` needs a format code and `R` needs to be boxable.
+/// Use `PYXX_BIND(f)` rather than spelling out the type.
+///
+///   static PyMethodDef methods[] = {
+///     Py::MethodDef("hypot", "...", PYXX_BIND(hypot)::call),
+///     ...
+template<typename F, F f>
+struct Bound;
+
+template<typename R, typename...A, R(*f)(A...)>
+struct Bound<R(*)(A...), f>
+{
+  using Result = R;
+  using Args = std::tuple<std::decay_t<A>...>;
+  using Indices = std::index_sequence_for<A...>;
+
+  static bool parse(PyObject *args, Args &xs)
+  {
+    return ParseTuple(args, xs, Indices());
+  }
+
+  template<typename Tuple>
+  static R apply(const Tuple &xs)
+  {
+    return apply_tuple(f, xs, Indices());
+  }
+
+  static PyObject *call(PyObject *, PyObject *args)
+  {
+    Args xs;
+    if (!parse(args, xs))
+      return nullptr;
+    return invoke(xs, std::is_void<R>());
+  }
+
+private:
+  static PyObject *invoke(const Args &xs, std::true_type)
+  {
+    apply(xs);
+    Py_RETURN_NONE;
+  }
+
+  static PyObject *invoke(const Args &xs, std::false_type)
+  {
+    return box(apply(xs));
+  }
+};
+
+#define PYXX_BIND(f) ::Py::Bound<decltype(&f), &f>
+
+}  // namespace py
+
+#endif  // PYXX_FUNCTION_H
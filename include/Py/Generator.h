@@ -0,0 +1,206 @@
+
+#ifndef PYXX_GENERATOR_H
+#define PYXX_GENERATOR_H
+
+#include <Python.h>
+
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Py/Compat.h"
+#include "Py/Object.h"
+#include "Py/Extention.h"
+#include "Py/Box.h"
+#include "Py/Thread.h"
+
+namespace Py {
+
+/// Where a `Generator`'s items come from.
+struct GeneratorSource
+{
+  virtual ~GeneratorSource() = default;
+
+  /// The next item as a new reference. Null with no exception set means the
+  /// source is exhausted.
+  virtual PyObject *next() = 0;
+};
+
+/// Walks a range it owns, boxing one element per step.
+template<typename Range>
+struct RangeSource : GeneratorSource
+{
+  using Iter = decltype(std::begin(std::declval<Range &>()));
+
+  Range range;
+  Iter it, end;
+
+  explicit RangeSource(Range r)
+    : range(std::move(r)), it(std::begin(range)), end(std::end(range))
+  {
+  }
+
+  PyObject *next() override
+  {
+    if (it == end)
+      return nullptr;
+    PyObject *o = box(*it);
+    ++it;
+    return o;
+  }
+};
+
+/// Calls `f(T &)` for each item until it returns false. With a `chunk` size,
+/// `f` fills a buffer that many items at a time, without the GIL, and the
+/// buffer is boxed an item at a time as Python asks for them.
+template<typename T, typename F>
+struct FunctionSource : GeneratorSource
+{
+  F f;
+  size_t chunk;
+  std::vector<T> buf;
+  size_t pos = 0;
+  bool done = false;
+
+  FunctionSource(F f, size_t chunk) : f(std::move(f)), chunk(chunk) { }
+
+  PyObject *next() override
+  {
+    if (pos == buf.size()) {
+      if (done || !refill())
+        return nullptr;
+      if (pos == buf.size())
+        return nullptr;
+    }
+    return box(buf[pos++]);
+  }
+
+private:
+  /// Returns false with an exception set if `f` threw.
+  bool refill()
+  {
+    buf.clear();
+    pos = 0;
+    std::string error;
+    if (chunk) {
+      AllowThreads nogil;
+      fill(chunk, error);
+    } else {
+      fill(1, error);
+    }
+
+    if (!error.empty()) {
+      done = true;
+      PyErr_SetString(PyExc_RuntimeError, error.c_str());
+      return false;
+    }
+    return true;
+  }
+
+  void fill(size_t n, std::string &error)
+  {
+    try {
+      while (buf.size() < n) {
+        T x;
+        if (!f(x)) {
+          done = true;
+          return;
+        }
+        buf.push_back(std::move(x));
+      }
+    } catch (const std::exception &e) {
+      error = e.what();
+    } catch (...) {
+      error = "unknown C++ exception";
+    }
+  }
+};
+
+struct GeneratorData
+{
+  std::unique_ptr<GeneratorSource> source;
+  std::mutex mutex;
+};
+
+/// A Python iterator over items produced in C++, boxed only as they are
+/// consumed, so a caller that stops early never pays for the rest. The
+/// iterator owns the producer's state.
+///
+///   // Keeps `v` alive, but boxes one element per next().
+///   return Py::Generator::from_range(std::move(v));
+///
+///   // Calls next_prime(p) until it returns false, 1024 at a time with
+///   // the GIL released.
+///   return Py::Generator::from_function<long>(next_prime, 1024);
+///
+/// A module that makes generators must call `Generator::Ready` in its init;
+/// making one before then raises `SystemError`. Modules in one process may
+/// share the type, so only the first call readies it (and names it).
+struct Generator : Extention<GeneratorData>
+{
+  static int Ready(const char *name = "pyxx.Generator")
+  {
+    static std::mutex m;
+    std::unique_lock<std::mutex> lock = lock_detached(m);
+    if (type.tp_flags & Py_TPFLAGS_READY)
+      return 0;
+    type.tp_name = name;
+    type.tp_iter = PyObject_SelfIter;
+    type.tp_iternext = iternext;
+    return PyType_Ready(&type);
+  }
+
+  /// Iterates over `r`, which the generator keeps.
+  template<typename Range>
+  static PyObject *from_range(Range r)
+  {
+    return make_with(
+      std::unique_ptr<GeneratorSource>(new RangeSource<Range>(std::move(r))));
+  }
+
+  /// Iterates over the items `f(T &)` writes, until it returns false. With
+  /// a `chunk` size, `f` runs without the GIL and must not touch Python.
+  template<typename T, typename F>
+  static PyObject *from_function(F f, size_t chunk = 0)
+  {
+    return make_with(std::unique_ptr<GeneratorSource>(
+      new FunctionSource<T, F>(std::move(f), chunk)));
+  }
+
+private:
+  static PyObject *make_with(std::unique_ptr<GeneratorSource> s)
+  {
+    if (!(type.tp_flags & Py_TPFLAGS_READY)) {
+      PyErr_SetString(PyExc_SystemError, "Py::Generator is not ready");
+      return nullptr;
+    }
+    PyObject *o = type.tp_new(&type, nullptr, nullptr);
+    if (o)
+      ((Generator *) o)->get().source = std::move(s);
+    return o;
+  }
+
+  static PyObject *iternext(PyObject *self)
+  {
+    GeneratorData &d = ((Generator *) self)->get();
+
+    // A refill may release the GIL, so another thread could get here
+    // meanwhile; wait for it without holding the GIL.
+    std::unique_lock<std::mutex> lock = lock_detached(d.mutex);
+
+    if (!d.source)
+      return nullptr;
+    PyObject *o = d.source->next();
+    if (!o && !PyErr_Occurred())
+      d.source.reset();
+    return o;
+  }
+};
+
+}  // namespace py
+
+#endif  // PYXX_GENERATOR_H
@@ -0,0 +1,421 @@
+
+#ifndef PYXX_LAZY_H
+#define PYXX_LAZY_H
+
+#include <Python.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "Py/Object.h"
+#include "Py/Extention.h"
+
+namespace Py {
+
+/// A deferred arithmetic expression over `T`, kept as a postfix program:
+/// a leaf pushes a value, and an operator replaces the values it takes with
+/// its result. Combining expressions appends one program to another, so
+/// there are no nodes to allocate, and `eval` is one loop over a stack.
+///
+/// Leaves hold a copy of their operand, so later mutation of the original
+/// object does not change the expression, just as with eager evaluation.
+template<typename T>
+struct LazyExpr
+{
+  using Bin = T(*)(const T &, const T &);
+  using Un  = T(*)(const T &);
+
+  /// One step: a binary or unary operator, or, with both null, the next of
+  /// `leaves`.
+  struct Op
+  {
+    Bin bin;
+    Un  un;
+  };
+
+  /// Programs longer than this are evaluated as they are built, so a loop
+  /// that keeps adding to one expression stays linear.
+  static constexpr size_t max_ops = 64;
+
+  std::vector<Op> ops;
+  std::vector<T> leaves;
+  size_t depth = 0;  // The stack `eval` needs.
+
+  /// Pushes `x`.
+  void push(const T &x)
+  {
+    depth = std::max<size_t>(depth, ops.empty() ? 1 : 2);
+    ops.push_back(Op{nullptr, nullptr});
+    leaves.push_back(x);
+  }
+
+  /// Pushes the value of `e`.
+  void push(const LazyExpr &e)
+  {
+    depth = std::max(depth, ops.empty() ? e.depth : e.depth + 1);
+    ops.insert(ops.end(), e.ops.begin(), e.ops.end());
+    leaves.insert(leaves.end(), e.leaves.begin(), e.leaves.end());
+  }
+
+  void apply(Bin f)
+  {
+    ops.push_back(Op{f, nullptr});
+    if (ops.size() > max_ops)
+      force();
+  }
+
+  void apply(Un f)
+  {
+    ops.push_back(Op{nullptr, f});
+    if (ops.size() > max_ops)
+      force();
+  }
+
+  T eval() const
+  {
+    if (ops.size() == 1)
+      return leaves[0];
+
+    std::vector<T> stack;
+    stack.reserve(depth);
+    auto leaf = leaves.begin();
+    for (const Op &op : ops) {
+      if (op.bin) {
+        T b = std::move(stack.back());
+        stack.pop_back();
+        stack.back() = op.bin(stack.back(), b);
+      } else if (op.un) {
+        stack.back() = op.un(stack.back());
+      } else {
+        stack.push_back(*leaf++);
+      }
+    }
+    return std::move(stack.back());
+  }
+
+  /// Evaluates the program and replaces it with its result, so evaluating
+  /// again, or building on it, costs nothing.
+  const T &force()
+  {
+    if (ops.size() != 1) {
+      T x = eval();
+      ops.assign(1, Op{nullptr, nullptr});
+      leaves.assign(1, std::move(x));
+      depth = 1;
+    }
+    return leaves[0];
+  }
+};
+
+/// An opt-in deferred form of `NumExtention<T>`.
+///
+/// Operators on `Lazy<T>` objects (mixed freely with `NumExtention<T>`
+/// operands) append to a `LazyExpr` instead of computing and boxing every
+/// intermediate; in-place operators append to the left operand itself. The
+/// expression is evaluated on `eval()`, `str`, `repr`, conversions, or any
+/// attribute lookup the expression itself does not define.
+///
+/// To make every operator of a type lazy, use
+/// `Extention<T>::type.tp_as_number = &Lazy<T>::numMethods`.
+template<typename T>
+struct Lazy : Extention<LazyExpr<T>>
+{
+  using Expr = LazyExpr<T>;
+  using Num  = NumExtention<T>;
+
+  static PyNumberMethods numMethods;
+  static PyMethodDef methods[];
+
+  static PyObject *make(Expr e)
+  {
+    PyObject *o = Lazy::type.tp_new(&Lazy::type, nullptr, nullptr);
+    if (o) ((Lazy *) o)->get() = std::move(e);
+    return o;
+  }
+
+  /// Wraps a `NumExtention<T>` (or another lazy expression) as a lazy leaf.
+  static PyObject *wrap(PyObject *o)
+  {
+    Expr e;
+    if (!push(e, o)) {
+      PyErr_SetString(PyExc_TypeError, "cannot make a lazy expression");
+      return nullptr;
+    }
+    return make(std::move(e));
+  }
+
+  /// Pushes the value of `o` onto `e`. Returns false if `o` is neither a
+  /// `Lazy<T>` nor a `T`.
+  static bool push(Expr &e, PyObject *o)
+  {
+    CriticalSection lock(o);
+    if (Lazy::type.IsSubtype(o))
+      e.push(((Lazy *) o)->get());
+    else if (Num::type.IsSubtype(o))
+      e.push(((Num *) o)->get());
+    else
+      return false;
+    return true;
+  }
+
+  /// Evaluates the expression and boxes the result.
+  PyObject *value()
+  {
+    CriticalSection lock((PyObject *) this);
+    return Num::make(this->get().force());
+  }
+
+  /// Fills in the slots for `Lazy<T>::type` and readies it.
+  static int Ready(const char *name)
+  {
+    Lazy::type.tp_name = name;
+#if !PYXX_PY3
+    Lazy::type.tp_flags |= Py_TPFLAGS_CHECKTYPES;
+#endif
+    Lazy::type.tp_as_number = &numMethods;
+    Lazy::type.tp_methods = methods;
+    Lazy::type.tp_str  = str;
+    Lazy::type.tp_repr = repr;
+    Lazy::type.tp_getattro = getattro;
+    return PyType_Ready(&Lazy::type);
+  }
+
+  static PyObject *eval(PyObject *self, PyObject *)
+  {
+    return ((Lazy *) self)->value();
+  }
+
+  static PyObject *str(PyObject *self)
+  {
+    Object v(((Lazy *) self)->value(), true);
+    return v.self ? PyObject_Str(v) : nullptr;
+  }
+
+  static PyObject *repr(PyObject *self)
+  {
+    Object v(((Lazy *) self)->value(), true);
+    return v.self ? PyObject_Repr(v) : nullptr;
+  }
+
+  static PyObject *getattro(PyObject *self, PyObject *name)
+  {
+    PyObject *attr = PyObject_GenericGetAttr(self, name);
+    if (attr || !PyErr_ExceptionMatches(PyExc_AttributeError))
+      return attr;
+
+    PyErr_Clear();
+    Object v(((Lazy *) self)->value(), true);
+    return v.self ? PyObject_GetAttr(v, name) : nullptr;
+  }
+};
+
+/// Lazy binary operators.
+///
+/// When `sym` yields a `T`, the slot appends the operator to a program, and
+/// the in-place slot appends it to the left operand's own program. When it
+/// yields something convertible to an `Object` (like a dot product), both
+/// sides are evaluated and the result is returned immediately, and the
+/// in-place slot is left unset.
+#define LAZY_BIN(sym, op)                                                      \
+  template<typename T>                                                         \
+  T lazy_apply_##op(const T &a, const T &b)                                    \
+  {                                                                            \
+    return a sym b;                                                            \
+  }                                                                            \
+                                                                               \
+  template<typename T,                                                         \
+           typename = std::enable_if_t<                                        \
+              std::is_same<T, std::decay_t<                                    \
+                decltype(std::declval<T>() sym std::declval<T>())              \
+              >>::value>                                                       \
+           >                                                                   \
+  binaryfunc lazy_##op(int)                                                    \
+  {                                                                            \
+    return [](PyObject *a, PyObject *b) -> PyObject * {                        \
+      using L = Lazy<T>;                                                       \
+      typename L::Expr e;                                                      \
+      if (!L::push(e, a) || !L::push(e, b)) {                                  \
+        Py_INCREF(Py_NotImplemented);                                          \
+        return Py_NotImplemented;                                              \
+      }                                                                        \
+      e.apply(lazy_apply_##op<T>);                                             \
+      return L::make(std::move(e));                                            \
+    };                                                                         \
+  }                                                                            \
+                                                                               \
+  template<typename T,                                                         \
+           typename R = decltype(std::declval<T>() sym std::declval<T>()),     \
+           typename = std::enable_if_t<                                        \
+              !std::is_same<T, std::decay_t<R>>::value &&                      \
+              std::is_constructible<Object, R>::value>                         \
+           >                                                                   \
+  binaryfunc lazy_##op(int)                                                    \
+  {                                                                            \
+    return [](PyObject *a, PyObject *b) -> PyObject * {                        \
+      using L = Lazy<T>;                                                       \
+      typename L::Expr x, y;                                                   \
+      if (!L::push(x, a) || !L::push(y, b)) {                                  \
+        Py_INCREF(Py_NotImplemented);                                          \
+        return Py_NotImplemented;                                              \
+      }                                                                        \
+      return Object(x.eval() sym y.eval());                                    \
+    };                                                                         \
+  }                                                                            \
+                                                                               \
+  template<typename T>                                                         \
+  std::nullptr_t lazy_##op(...) {                                              \
+    return nullptr;                                                            \
+  }                                                                            \
+                                                                               \
+  template<typename T,                                                         \
+           typename = std::enable_if_t<                                        \
+              std::is_same<T, std::decay_t<                                    \
+                decltype(std::declval<T>() sym std::declval<T>())              \
+              >>::value>                                                       \
+           >                                                                   \
+  binaryfunc lazy_inplace_##op(int)                                            \
+  {                                                                            \
+    return [](PyObject *a, PyObject *b) -> PyObject * {                        \
+      using L = Lazy<T>;                                                       \
+      typename L::Expr rhs;                                                    \
+      if (!L::type.IsSubtype(a) || !L::push(rhs, b)) {                         \
+        Py_INCREF(Py_NotImplemented);                                          \
+        return Py_NotImplemented;                                              \
+      }                                                                        \
+                                                                               \
+      {                                                                        \
+        CriticalSection lock(a);                                               \
+        typename L::Expr &e = ((L *) a)->get();                                \
+        e.push(rhs);                                                           \
+        e.apply(lazy_apply_##op<T>);                                           \
+      }                                                                        \
+      Py_INCREF(a);                                                            \
+      return a;                                                                \
+    };                                                                         \
+  }                                                                            \
+                                                                               \
+  template<typename T>                                                         \
+  std::nullptr_t lazy_inplace_##op(...) {                                      \
+    return nullptr;                                                            \
+  }                                                                            \
+
+#define LAZY_UNARY(sym, op)                                                    \
+  template<typename T>                                                         \
+  T lazy_apply_##op(const T &a)                                                \
+  {                                                                            \
+    return sym a;                                                              \
+  }                                                                            \
+                                                                               \
+  template<typename T,                                                         \
+           typename = std::enable_if_t<                                        \
+              std::is_same<T, std::decay_t<                                    \
+                decltype(sym std::declval<T>())                                \
+              >>::value>                                                       \
+           >                                                                   \
+  unaryfunc lazy_##op(int)                                                     \
+  {                                                                            \
+    return [](PyObject *o) -> PyObject * {                                     \
+      using L = Lazy<T>;                                                       \
+      typename L::Expr e;                                                      \
+      if (!L::push(e, o)) {                                                    \
+        PyErr_SetString(PyExc_TypeError, "bad operand for unary " #sym);       \
+        return nullptr;                                                        \
+      }                                                                        \
+      e.apply(lazy_apply_##op<T>);                                             \
+      return L::make(std::move(e));                                            \
+    };                                                                         \
+  }                                                                            \
+                                                                               \
+  template<typename T>                                                         \
+  std::nullptr_t lazy_##op(...) {                                              \
+    return nullptr;                                                            \
+  }                                                                            \
+
+template<typename T, typename U>
+auto lazy_conversion(int)
+  -> decltype(static_cast<U>(std::declval<T>()), unaryfunc())
+{
+  return [](PyObject *o) -> PyObject * {
+    typename Lazy<T>::Expr e;
+    if (!Lazy<T>::push(e, o)) {
+      PyErr_SetString(PyExc_TypeError, "bad operand for conversion");
+      return nullptr;
+    }
+    return Object(static_cast<U>(e.eval()));
+  };
+}
+
+template<typename T, typename U>
+std::nullptr_t lazy_conversion(...) {
+  return nullptr;
+}
+
+LAZY_BIN(+,  plus);
+LAZY_BIN(-,  subtract);
+LAZY_BIN(*,  multiply);
+LAZY_BIN(/,  divide);
+LAZY_BIN(%,  modulus);
+LAZY_BIN(^,  xor);
+LAZY_BIN(<<, lshift);
+LAZY_BIN(>>, rshift);
+LAZY_BIN(&,  and);
+LAZY_BIN(|,  or);
+
+LAZY_UNARY(+, positive);
+LAZY_UNARY(-, negative);
+LAZY_UNARY(~, invert);
+
+#undef LAZY_BIN
+#undef LAZY_UNARY
+
+template<typename T>
+PyNumberMethods lazy_number_methods()
+{
+  PyNumberMethods m = { };
+  m.nb_add       = lazy_plus<T>(0);
+  m.nb_subtract  = lazy_subtract<T>(0);
+  m.nb_multiply  = lazy_multiply<T>(0);
+  m.nb_remainder = lazy_modulus<T>(0);
+  m.nb_negative  = lazy_negative<T>(0);
+  m.nb_positive  = lazy_positive<T>(0);
+  m.nb_invert    = lazy_invert<T>(0);
+  m.nb_lshift    = lazy_lshift<T>(0);
+  m.nb_rshift    = lazy_rshift<T>(0);
+  m.nb_and       = lazy_and<T>(0);
+  m.nb_xor       = lazy_xor<T>(0);
+  m.nb_or        = lazy_or<T>(0);
+  m.nb_inplace_add       = lazy_inplace_plus<T>(0);
+  m.nb_inplace_subtract  = lazy_inplace_subtract<T>(0);
+  m.nb_inplace_multiply  = lazy_inplace_multiply<T>(0);
+  m.nb_inplace_remainder = lazy_inplace_modulus<T>(0);
+  m.nb_inplace_lshift    = lazy_inplace_lshift<T>(0);
+  m.nb_inplace_rshift    = lazy_inplace_rshift<T>(0);
+  m.nb_inplace_and       = lazy_inplace_and<T>(0);
+  m.nb_inplace_xor       = lazy_inplace_xor<T>(0);
+  m.nb_inplace_or        = lazy_inplace_or<T>(0);
+  m.nb_int       = lazy_conversion<T, long>(0);
+  m.nb_float     = lazy_conversion<T, double>(0);
+#if PYXX_PY3
+  m.nb_true_divide = lazy_divide<T>(0);
+  m.nb_inplace_true_divide = lazy_inplace_divide<T>(0);
+#else
+  m.nb_divide    = lazy_divide<T>(0);
+  m.nb_inplace_divide = lazy_inplace_divide<T>(0);
+  m.nb_long      = lazy_conversion<T, long long>(0);
+#endif
+  return m;
+}
+
+template<typename T>
+PyNumberMethods Lazy<T>::numMethods = lazy_number_methods<T>();
+
+template<typename T>
+PyMethodDef Lazy<T>::methods[] = {
+  {"eval", Lazy<T>::eval, METH_NOARGS,
+   "Evaluates the expression."},
+  {NULL, NULL, 0, NULL}
+};
+
+}  // namespace py
+
+#endif  // PYXX_LAZY_H
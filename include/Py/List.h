@@ -6,6 +6,10 @@
 
 #include <algorithm>
 #include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include "Py/Sort.h"
 
 namespace Py {
 
@@ -83,8 +87,8 @@ struct List : Object
 
   const_reference front() const noexcept { return (*this)[0]; }
   reference       front()       noexcept { return (*this)[0]; }
-  const_reference back()  const noexcept { return (*this)[size()]; }
-  reference       back()        noexcept { return (*this)[size()]; }
+  const_reference back()  const noexcept { return (*this)[size() - 1]; }
+  reference       back()        noexcept { return (*this)[size() - 1]; }
 
   reference       Get(size_type i)       noexcept { return (*this)[i]; }
   const_reference Get(size_type i) const noexcept { return (*this)[i]; }
@@ -130,10 +134,53 @@ struct List : Object
     return PyList_Append(self, const_cast<List &>(l)) == 0;
   }
 
+  /// Makes room for `n` items, so appending up to that many never
+  /// reallocates. Free-threaded builds share list storage between threads,
+  /// so there it is only a hint.
+  bool reserve(size_type n) noexcept {
+#ifndef Py_GIL_DISABLED
+    PyListObject *l = ptr();
+    if (n <= l->allocated)
+      return true;
+    PyObject **items = PyMem_Resize(l->ob_item, PyObject *, n);
+    if (!items) {
+      PyErr_NoMemory();
+      return false;
+    }
+    l->ob_item = items;
+    l->allocated = n;
+#endif
+    (void) n;
+    return true;
+  }
+
+  /// Appends each of `[first, last)`, boxed like `push_back`. Forward ranges
+  /// grow the list once and fill the new slots in place. On failure nothing
+  /// is appended.
+  template<typename It>
+  bool extend(It first, It last) noexcept {
+    return extend(first, last,
+                  typename std::iterator_traits<It>::iterator_category());
+  }
+
+  template<typename Range>
+  bool extend(const Range &r) noexcept {
+    return extend(std::begin(r), std::end(r));
+  }
+
   bool Sort() noexcept {
     return PyList_Sort(self) == 0;
   }
 
+  /// Like `Sort()`, but all-int, all-float and all-str lists are sorted on
+  /// unboxed keys. See `Py::SortUnboxed`.
+  bool SortUnboxed() noexcept {
+    return Py::SortUnboxed(self);
+  }
+  bool SortUnboxed(PyObject *key) noexcept {
+    return Py::SortUnboxed(self, key);
+  }
+
   bool Reverse() noexcept {
     return PyList_Reverse(self) == 0;
   }
@@ -141,8 +188,93 @@ struct List : Object
   PyObject *AsTuple() const noexcept {
     return PyList_AsTuple(self);
   }
+
+private:
+  template<typename It>
+  bool extend(It first, It last, std::input_iterator_tag) noexcept {
+    size_type n = size();
+    for (; first != last; ++first)
+      if (!push_back(*first)) {
+        Set(n, size(), nullptr);
+        return false;
+      }
+    return true;
+  }
+
+  template<typename It>
+  bool extend(It first, It last, std::forward_iterator_tag) noexcept {
+    size_type k = std::distance(first, last);
+    if (k == 0)
+      return true;
+#ifdef Py_GIL_DISABLED
+    // Fill a list of our own, then splice it in with one resize.
+    List tail(k);
+    if (!tail.self)
+      return false;
+    for (size_type i = 0; i < k; ++i, ++first)
+      if (!(tail[i] = object_ptr(*first)))
+        return false;
+    return Set(size(), size(), tail);
+#else
+    size_type n = size();
+    if (!reserve(n + k))
+      return false;
+    PyObject **items = data();
+    for (size_type i = 0; i < k; ++i, ++first) {
+      if (!(items[n + i] = object_ptr(*first))) {
+        while (i--)
+          Py_DECREF(items[n + i]);
+        return false;
+      }
+    }
+    ((PyVarObject *) self)->ob_size = n + k;
+    return true;
+#endif
+  }
+};
+
+/// An output iterator that appends to a `List`, like
+/// `std::back_insert_iterator`, but takes anything `push_back` does. After
+/// the first failed append it drops the rest, leaving the exception set for
+/// the caller to find with `ok()`.
+///
+///   auto it = std::copy(v.begin(), v.end(), Py::back_inserter(l));
+///   if (!it.ok())
+///     return nullptr;
+struct ListBackInserter
+{
+  using iterator_category = std::output_iterator_tag;
+  using value_type        = void;
+  using difference_type   = ptrdiff_t;
+  using pointer           = void;
+  using reference         = void;
+  using container_type    = List;
+
+  List *list;
+  bool failed = false;
+
+  explicit ListBackInserter(List &l) noexcept : list(&l) { }
+
+  template<typename O, typename = typename std::enable_if<
+    !std::is_same<typename std::decay<O>::type, ListBackInserter>::value>::type>
+  ListBackInserter &operator= (O &&o) noexcept {
+    if (!failed)
+      failed = !list->push_back(std::forward<O>(o));
+    return *this;
+  }
+
+  ListBackInserter &operator* () noexcept { return *this; }
+  ListBackInserter &operator++ () noexcept { return *this; }
+  ListBackInserter &operator++ (int) noexcept { return *this; }
+
+  bool ok() const noexcept { return !failed; }
 };
 
+inline ListBackInserter back_inserter(List &l) noexcept
+{
+  return ListBackInserter(l);
+}
+
 }  // namespace py
 
 #endif  // PYXX_LIST_H
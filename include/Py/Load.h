@@ -0,0 +1,499 @@
+
+#ifndef PYXX_LOAD_H
+#define PYXX_LOAD_H
+
+#include <Python.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <clocale>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#ifndef _WIN32
+# include <locale.h>
+#endif
+#ifdef __APPLE__
+# include <xlocale.h>
+#endif
+
+#include "Py/Compat.h"
+#include "Py/Object.h"
+#include "Py/Buffer.h"
+#include "Py/Thread.h"
+
+/// Bulk loading of numbers from files straight into a `std::vector<T>`,
+/// for an `Array<T>` to hand to Python, without a Python object per value.
+///
+/// A file is read a chunk at a time, so besides the result only one chunk
+/// is held. Each chunk of text is cut at line ends into a piece per thread
+/// and parsed on `ThreadPool::global()`. Everything runs with the GIL
+/// released; a failure sets an exception once it is taken back.
+///
+///   std::vector<Vec> vs;
+///   if (!Py::load_text(path, vs))
+///     return nullptr;
+///   return Py::Array<Vec>::make(std::move(vs));
+
+namespace Py {
+
+/// How `load_text` reads rows. Each row is one `T`: `ItemFormat<T>::width`
+/// numbers, separated by blanks or by one `delimiter` between blanks.
+struct TextFormat
+{
+  char delimiter = ',';
+  char comment = '#';     // Lines starting with it are skipped; 0 for none.
+  size_t skip = 0;        // Lines to skip first, such as a header.
+  size_t chunk = 8 << 20; // Bytes read at a time.
+};
+
+/// How `load_records` reads fixed-size binary records, in native byte
+/// order. Each record holds one `T`, packed, at `offset`.
+struct RecordFormat
+{
+  size_t record = 0;      // Bytes per record; 0 means `sizeof(T)`.
+  size_t offset = 0;
+  size_t header = 0;      // Bytes to skip at the start of the file.
+  size_t chunk = 8 << 20;
+};
+
+/// `strtod` in the "C" locale, so a decimal point is '.' whatever
+/// `LC_NUMERIC` says.
+inline double c_strtod(const char *s, char **end)
+{
+#ifdef _WIN32
+  static const _locale_t c = _create_locale(LC_NUMERIC, "C");
+  return c ? _strtod_l(s, end, c) : std::strtod(s, end);
+#else
+  static const locale_t c = newlocale(LC_NUMERIC_MASK, "C", (locale_t) 0);
+  return c ? strtod_l(s, end, c) : std::strtod(s, end);
+#endif
+}
+
+/// Reads a decimal number from `[p, end)` into `x`. Returns the end of
+/// it, or null if there isn't one.
+///
+/// Numbers of up to 15 digits with small exponents, which is what most
+/// data files hold, are converted exactly in double arithmetic; anything
+/// else, and "inf" or "nan", goes to `c_strtod`.
+inline const char *parse_number(const char *p, const char *end, double &x)
+{
+  static const double pow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+  };
+
+  const char *s = p;
+  bool neg = false;
+  if (p < end && (*p == '-' || *p == '+'))
+    neg = *p++ == '-';
+
+  uint64_t m = 0;
+  int digits = 0, exp = 0;
+  bool any = false;
+  for (; p < end && (unsigned) (*p - '0') < 10; p++, any = true) {
+    if (digits < 19) {
+      m = m * 10 + (*p - '0');
+      digits += m != 0;
+    } else {
+      exp++;
+      digits++;
+    }
+  }
+  if (p < end && *p == '.') {
+    for (p++; p < end && (unsigned) (*p - '0') < 10; p++, any = true) {
+      if (digits < 19) {
+        m = m * 10 + (*p - '0');
+        digits += m != 0;
+        exp--;
+      } else {
+        digits++;
+      }
+    }
+  }
+
+  if (!any) {
+    // Maybe "inf" or "nan".
+    char buf[16] = { };
+    size_t n = std::min<size_t>(end - s, sizeof buf - 1);
+    std::memcpy(buf, s, n);
+    char *e;
+    x = c_strtod(buf, &e);
+    return e == buf ? nullptr : s + (e - buf);
+  }
+
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    const char *q = p + 1;
+    bool eneg = false;
+    if (q < end && (*q == '-' || *q == '+'))
+      eneg = *q++ == '-';
+    if (q < end && (unsigned) (*q - '0') < 10) {
+      int e = 0;
+      for (; q < end && (unsigned) (*q - '0') < 10; q++)
+        e = std::min(e * 10 + (*q - '0'), 100000);
+      exp += eneg ? -e : e;
+      p = q;
+    }
+  }
+
+  if (digits <= 15 && exp >= -22 && exp <= 22) {
+    x = exp < 0 ? m / pow10[-exp] : m * pow10[exp];
+    if (neg)
+      x = -x;
+    return p;
+  }
+
+  // Too many digits to round once; let the C library do it.
+  std::string buf(s, p);
+  x = c_strtod(buf.c_str(), nullptr);
+  return p;
+}
+
+inline const char *parse_number(const char *p, const char *end, float &x)
+{
+  double d;
+  p = parse_number(p, end, d);
+  x = (float) d;
+  return p;
+}
+
+template<typename T>
+auto parse_number(const char *p, const char *end, T &x)
+  -> std::enable_if_t<std::is_integral<T>::value, const char *>
+{
+  bool neg = false;
+  if (p < end && (*p == '-' || *p == '+'))
+    neg = *p++ == '-';
+  if (neg && !std::is_signed<T>::value)
+    return nullptr;
+
+  // Accumulated negatively when signed, so the minimum fits.
+  using Wide = std::conditional_t<std::is_signed<T>::value,
+                                  long long, unsigned long long>;
+  const Wide lo = std::numeric_limits<T>::min(),
+             hi = std::numeric_limits<T>::max();
+  Wide v = 0;
+  const char *s = p;
+  for (; p < end && (unsigned) (*p - '0') < 10; p++) {
+    Wide d = *p - '0';
+    if (neg ? v < (lo + (Wide) d) / 10 : v > (hi - d) / 10)
+      return nullptr;
+    v = neg ? v * 10 - d : v * 10 + d;
+  }
+  if (p == s)
+    return nullptr;
+  x = (T) v;
+  return p;
+}
+
+/// Parses the rows of `[p, end)`, which holds whole lines, onto `out`.
+/// Counts the lines in `lines`; on a bad row, stops there and returns
+/// what is wrong with it.
+template<typename T>
+const char *parse_rows(const char *p, const char *end, const TextFormat &fmt,
+                       std::vector<T> &out, size_t &lines)
+{
+  using Format    = ItemFormat<T>;
+  using Component = typename Format::component;
+
+  auto blank = [](char c) { return c == ' ' || c == '\t' || c == '\r'; };
+
+  lines = 0;
+  while (p < end) {
+    const char *eol = (const char *) std::memchr(p, '\n', end - p);
+    if (!eol)
+      eol = end;
+    while (p < eol && blank(*p))
+      p++;
+
+    if (p < eol && *p != fmt.comment) {
+      T row;
+      Component *c = (Component *) &row;
+      for (Py_ssize_t i = 0; i < Format::width; i++) {
+        if (i > 0) {
+          while (p < eol && blank(*p))
+            p++;
+          if (p < eol && *p == fmt.delimiter)
+            p++;
+          while (p < eol && blank(*p))
+            p++;
+        }
+        if (p == eol)
+          return "too few values";
+        p = parse_number(p, eol, c[i]);
+        if (!p || (p < eol && !blank(*p) && *p != fmt.delimiter &&
+                   *p != fmt.comment))
+          return "not a number";
+      }
+      while (p < eol && blank(*p))
+        p++;
+      if (p < eol && *p != fmt.comment)
+        return "too many values";
+      out.push_back(row);
+    }
+
+    lines++;
+    p = eol + 1;
+  }
+  return nullptr;
+}
+
+/// An open file, closed on destruction.
+struct File
+{
+  FILE *f = nullptr;
+
+  File() = default;
+  ~File() { if (f) std::fclose(f); }
+
+  File(const File &) = delete;
+  File &operator= (const File &) = delete;
+
+  /// Opens `path`, a str, bytes or, on Python 3, os.PathLike, for binary
+  /// reading. Returns false with an exception set if it can't.
+  bool open(PyObject *path)
+  {
+#if PYXX_PY3
+    PyObject *bytes;
+    if (!PyUnicode_FSConverter(path, &bytes))
+      return false;
+    Object name(bytes, true);
+    const char *s = PyBytes_AS_STRING(bytes);
+#else
+    const char *s = PyString_AsString(path);
+    if (!s)
+      return false;
+#endif
+    {
+      AllowThreads nogil;
+      f = std::fopen(s, "rb");
+    }
+    if (!f) {
+      PyErr_SetFromErrnoWithFilenameObject(PyExc_IOError, path);
+      return false;
+    }
+    return true;
+  }
+
+  /// The size of the file, or 0 if it can't be told.
+  size_t size()
+  {
+    long here = std::ftell(f);
+    if (here < 0 || std::fseek(f, 0, SEEK_END) != 0)
+      return 0;
+    long n = std::ftell(f);
+    std::fseek(f, here, SEEK_SET);
+    return n > 0 ? n : 0;
+  }
+};
+
+/// Appends a `T` for each row of text in the file at `path` to `out`.
+/// Returns false with an exception set if the file can't be read, or a
+/// ValueError naming the line if a row doesn't parse.
+template<typename T>
+bool load_text(PyObject *path, std::vector<T> &out,
+               const TextFormat &fmt = TextFormat())
+{
+  File file;
+  if (!file.open(path))
+    return false;
+
+  const char *error = nullptr;
+  size_t line = 0;  // Lines before the current chunk.
+  int err = 0;
+  {
+    AllowThreads nogil;
+
+    ThreadPool &pool = ThreadPool::global();
+    size_t total = file.size(), consumed = 0, start = out.size();
+    size_t chunk = std::max<size_t>(fmt.chunk, 1);
+    size_t skip = fmt.skip;
+
+    std::vector<char> buf;
+    std::vector<std::vector<T>> parts(pool.size() + 1);
+    std::vector<size_t> counts(parts.size());
+    std::vector<const char *> errors(parts.size());
+    size_t held = 0;  // Bytes of an unfinished line carried over.
+    bool eof = false, guessed = false;
+
+    while (!eof && !error) {
+      // A line longer than the chunk makes the buffer grow to fit it.
+      buf.resize(held + chunk);
+      size_t got = std::fread(buf.data() + held, 1, chunk, file.f);
+      if (got < chunk) {
+        if (std::ferror(file.f)) {
+          err = errno ? errno : EIO;
+          break;
+        }
+        eof = true;
+      }
+
+      const char *begin = buf.data(), *end = begin + held + got;
+      const char *cut = end;
+      if (!eof) {
+        // What is carried over holds no line end, so only look past it.
+        while (cut > begin + held && cut[-1] != '\n')
+          cut--;
+        if (cut == begin + held) {
+          held += got;
+          continue;
+        }
+      }
+
+      for (; skip && begin < cut; skip--, line++) {
+        const char *eol = (const char *) std::memchr(begin, '\n', cut - begin);
+        begin = eol ? eol + 1 : cut;
+      }
+
+      // Split at line ends into up to one piece per thread.
+      size_t n = parts.size();
+      std::vector<const char *> bounds(n + 1, cut);
+      bounds[0] = begin;
+      for (size_t i = 1; i < n; i++) {
+        const char *b = std::max(bounds[i - 1],
+                                 begin + (cut - begin) * i / n);
+        const char *eol = b > begin && b[-1] == '\n' ? b - 1 :
+          (const char *) std::memchr(b, '\n', cut - b);
+        bounds[i] = eol ? eol + 1 : cut;
+      }
+
+      parallel_for(n, 1, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; i++) {
+          parts[i].clear();
+          errors[i] = parse_rows(bounds[i], bounds[i + 1], fmt, parts[i],
+                                 counts[i]);
+        }
+      }, pool);
+
+      for (size_t i = 0; i < n && !error; i++) {
+        out.insert(out.end(), parts[i].begin(), parts[i].end());
+        line += counts[i];
+        error = errors[i];
+      }
+
+      // Having seen a chunk, guess how many rows the file holds.
+      consumed += cut - buf.data();
+      if (!guessed && !error && total > consumed && out.size() > start) {
+        out.reserve(out.size() +
+                    (out.size() - start) * (total - consumed) / consumed + 1);
+        guessed = true;
+      }
+
+      held = end - cut;
+      std::memmove(buf.data(), cut, held);
+    }
+  }
+
+  if (err) {
+    errno = err;
+    PyErr_SetFromErrnoWithFilenameObject(PyExc_IOError, path);
+    return false;
+  }
+  if (error) {
+    PyErr_Format(PyExc_ValueError, "line %zu: %s", line + 1, error);
+    return false;
+  }
+  return true;
+}
+
+/// Appends the `T` in each binary record of the file at `path` to `out`.
+/// Returns false with an exception set if the file can't be read, or a
+/// ValueError if it ends partway through a record.
+template<typename T>
+bool load_records(PyObject *path, std::vector<T> &out,
+                  const RecordFormat &fmt = RecordFormat())
+{
+  static_assert(std::is_trivially_copyable<T>::value,
+                "Records are copied bytewise.");
+
+  size_t record = fmt.record ? fmt.record : sizeof(T);
+  if (fmt.offset + sizeof(T) > record) {
+    PyErr_Format(PyExc_ValueError,
+                 "a %zu-byte value at offset %zu overruns a %zu-byte record",
+                 sizeof(T), fmt.offset, record);
+    return false;
+  }
+
+  File file;
+  if (!file.open(path))
+    return false;
+
+  size_t partial = 0;
+  int err = 0;
+  {
+    AllowThreads nogil;
+
+    size_t total = file.size();
+    if (fmt.header && std::fseek(file.f, fmt.header, SEEK_SET) != 0)
+      err = errno;
+    if (total > fmt.header)
+      out.reserve(out.size() + (total - fmt.header) / record);
+
+    // Packed records are read straight into `out`, no more than the file
+    // was said to hold, so the exact reserve holds; others through a
+    // buffer of whole records, picked apart in parallel.
+    size_t per = std::max<size_t>(fmt.chunk / record, 1);
+    size_t left = !total ? std::numeric_limits<size_t>::max()
+                : total > fmt.header ? (total - fmt.header) / record : 0;
+    std::vector<char> buf(record == sizeof(T) ? 0 : per * record);
+
+    while (!err) {
+      size_t at = out.size();
+      size_t got, want;
+      if (!buf.empty()) {
+        want = buf.size();
+        got = std::fread(buf.data(), 1, want, file.f);
+        out.resize(at + got / record);
+        T *dst = out.data() + at;
+        const char *src = buf.data() + fmt.offset;
+        parallel_for(got / record, 1 << 14, [&](size_t b, size_t e) {
+          for (size_t i = b; i < e; i++)
+            std::memcpy(dst + i, src + i * record, sizeof(T));
+        });
+      } else if (left) {
+        size_t n = std::min(per, left);
+        want = n * record;
+        out.resize(at + n);
+        got = std::fread(out.data() + at, 1, want, file.f);
+        out.resize(at + got / record);
+        left -= got / record;
+      } else {
+        // Past the size told: a partial record, or the file grew.
+        T x;
+        want = record;
+        got = std::fread(&x, 1, want, file.f);
+        if (got == want)
+          out.push_back(x);
+      }
+
+      if (got < want) {
+        if (std::ferror(file.f))
+          err = errno ? errno : EIO;
+        partial = got % record;
+        break;
+      }
+    }
+  }
+
+  if (err) {
+    errno = err;
+    PyErr_SetFromErrnoWithFilenameObject(PyExc_IOError, path);
+    return false;
+  }
+  if (partial) {
+    PyErr_Format(PyExc_ValueError, "file ends %zu bytes into a record",
+                 partial);
+    return false;
+  }
+  return true;
+}
+
+}  // namespace py
+
+#endif  // PYXX_LOAD_H
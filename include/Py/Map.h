@@ -0,0 +1,158 @@
+
+#ifndef PYXX_MAP_H
+#define PYXX_MAP_H
+
+#include <Python.h>
+
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Py/Object.h"
+#include "Py/Box.h"
+#include "Py/Function.h"
+#include "Py/List.h"
+#include "Py/Thread.h"
+#include "Py/Tuple.h"
+
+namespace Py {
+
+/// Parses one argument tuple per element of the sequence `rows`.
+template<typename Args>
+bool ParseRows(PyObject *rows, std::vector<Args> &out,
+               bool (*parse)(PyObject *, Args &))
+{
+  Object seq(PySequence_Fast(rows,
+                             "map() needs an iterable of argument tuples"),
+             true);
+  if (!seq.self)
+    return false;
+
+  Py_ssize_t n = PySequence_Fast_GET_SIZE(seq.self);
+  PyObject **items = PySequence_Fast_ITEMS(seq.self);
+  out.resize(n);
+  for (Py_ssize_t i = 0; i < n; i++) {
+    bool tuple = PyTuple_Check(items[i]);
+    Object args(tuple ? items[i] : PySequence_Tuple(items[i]), !tuple);
+    if (!args.self || !parse(args, out[i]))
+      return false;
+  }
+  return true;
+}
+
+/// Parses the `i`th element of every column into `out[i]`.
+template<typename...Xs, size_t...Is>
+bool ParseColumns(PyObject *cols, std::vector<std::tuple<Xs...>> &out,
+                  std::index_sequence<Is...>)
+{
+  std::vector<Object> seqs;
+  seqs.reserve(sizeof...(Is));
+  for (Py_ssize_t c = 0; c < (Py_ssize_t) sizeof...(Is); c++) {
+    seqs.emplace_back(PySequence_Fast(PyTuple_GET_ITEM(cols, c),
+                                      "map() columns must be iterable"),
+                      true);
+    if (!seqs.back().self)
+      return false;
+  }
+
+  Py_ssize_t n = PySequence_Fast_GET_SIZE(seqs[0].self);
+  for (Object &s : seqs) {
+    if (PySequence_Fast_GET_SIZE(s.self) != n) {
+      PyErr_SetString(PyExc_ValueError, "map() columns differ in length");
+      return false;
+    }
+  }
+
+  out.resize(n);
+  for (Py_ssize_t i = 0; i < n; i++) {
+    bool ok = true;
+    (void) std::initializer_list<int>{
+      (ok = ok && ParseValue(PySequence_Fast_GET_ITEM(seqs[Is].self, i),
+                             std::get<Is>(out[i])), 0)...
+    };
+    if (!ok)
+      return false;
+  }
+  return true;
+}
+
+/// The batched form of a `Bound` function, `f`, for calling it many times
+/// from one Python call:
+///
+///   f_map([(a0, b0), (a1, b1), ...])    # one tuple per call
+///   f_map([a0, a1, ...], [b0, b1, ...])  # one sequence per parameter
+///
+/// Every argument is parsed up front, then `f` runs in a tight loop and the
+/// results are boxed into a preallocated list. With `NoGil`, the loop runs
+/// with the GIL released; only use it when `f` never touches Python.
+///
+///   Py::MethodDef("cross_map", "...", PYXX_MAP(cross)::call),
+template<typename F, F f, bool NoGil = false>
+struct Map
+{
+  using Fn      = Bound<F, f>;
+  using Args    = typename Fn::Args;
+  using Result  = std::decay_t<typename Fn::Result>;
+  using Indices = typename Fn::Indices;
+
+  static_assert(!std::is_void<Result>::value,
+                "map() needs a function that returns a value.");
+  static_assert(!NoGil || !std::is_convertible<Result, PyObject *>::value,
+                "A function returning Python objects needs the GIL.");
+
+  static constexpr size_t arity = std::tuple_size<Args>::value;
+
+  static PyObject *call(PyObject *, PyObject *args)
+  {
+    Py_ssize_t nargs = PyTuple_GET_SIZE(args);
+    std::vector<Args> xs;
+
+    if (nargs == 1 && arity != 1) {
+      if (!ParseRows(PyTuple_GET_ITEM(args, 0), xs, Fn::parse))
+        return nullptr;
+    } else if (nargs == (Py_ssize_t) arity && arity > 0) {
+      if (!ParseColumns(args, xs, Indices()))
+        return nullptr;
+    } else {
+      PyErr_Format(PyExc_TypeError,
+                   "map() takes one iterable of argument tuples or %d "
+                   "iterables (%zd given)", (int) arity, nargs);
+      return nullptr;
+    }
+
+    std::vector<Result> rs;
+    rs.reserve(xs.size());
+    run(xs, rs, std::integral_constant<bool, NoGil>());
+
+    List l(rs.size());
+    if (!l.self)
+      return nullptr;
+    for (size_t i = 0; i < rs.size(); i++)
+      if (!(l[i] = box(rs[i])))
+        return nullptr;
+    return std::move(l);
+  }
+
+private:
+  static void run(const std::vector<Args> &xs, std::vector<Result> &rs,
+                  std::false_type)
+  {
+    for (const Args &x : xs)
+      rs.push_back(Fn::apply(x));
+  }
+
+  static void run(const std::vector<Args> &xs, std::vector<Result> &rs,
+                  std::true_type)
+  {
+    AllowThreads nogil;
+    run(xs, rs, std::false_type());
+  }
+};
+
+#define PYXX_MAP(f)       ::Py::Map<decltype(&f), &f>
+#define PYXX_MAP_NOGIL(f) ::Py::Map<decltype(&f), &f, true>
+
+}  // namespace py
+
+#endif  // PYXX_MAP_H
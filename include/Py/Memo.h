@@ -0,0 +1,255 @@
+
+#ifndef PYXX_MEMO_H
+#define PYXX_MEMO_H
+
+#include <Python.h>
+
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#if __cplusplus >= 201703L
+# include <string_view>
+#endif
+
+#include "Py/Compat.h"
+#include "Py/Object.h"
+#include "Py/Box.h"
+#include "Py/Function.h"
+#include "Py/Tuple.h"
+
+namespace Py {
+
+/// Hashes a tuple by combining the `std::hash` of each element.
+struct TupleHash
+{
+  template<typename...Ts>
+  size_t operator() (const std::tuple<Ts...> &t) const
+  {
+    return hash(t, std::index_sequence_for<Ts...>());
+  }
+
+private:
+  template<typename...Ts, size_t...Is>
+  static size_t hash(const std::tuple<Ts...> &t, std::index_sequence<Is...>)
+  {
+    size_t h = 0;
+    (void) std::initializer_list<int>{
+      (h ^= std::hash<Ts>()(std::get<Is>(t)) + 0x9e3779b9 + (h << 6) + (h >> 2),
+       0)...
+    };
+    return h;
+  }
+};
+
+/// A bounded least-recently-used map from `K` to `V`.
+template<typename K, typename V, typename Hash = std::hash<K>>
+struct LruCache
+{
+  explicit LruCache(size_t capacity) : capacity(capacity) { }
+
+  /// The cached value for `k`, made most recent, or null.
+  const V *find(const K &k)
+  {
+    auto it = index.find(k);
+    if (it == index.end()) {
+      misses++;
+      return nullptr;
+    }
+    hits++;
+    order.splice(order.begin(), order, it->second);
+    return &it->second->second;
+  }
+
+  void insert(const K &k, V v)
+  {
+    auto it = index.find(k);
+    if (it != index.end()) {
+      it->second->second = std::move(v);
+      order.splice(order.begin(), order, it->second);
+      return;
+    }
+    if (capacity == 0)
+      return;
+    if (index.size() == capacity) {
+      index.erase(order.back().first);
+      order.pop_back();
+    }
+    order.emplace_front(k, std::move(v));
+    index.emplace(k, order.begin());
+  }
+
+  bool erase(const K &k)
+  {
+    auto it = index.find(k);
+    if (it == index.end())
+      return false;
+    order.erase(it->second);
+    index.erase(it);
+    return true;
+  }
+
+  void clear()
+  {
+    index.clear();
+    order.clear();
+    hits = misses = 0;
+  }
+
+  size_t size() const { return index.size(); }
+
+  const size_t capacity;
+  size_t hits = 0, misses = 0;
+
+private:
+  using Entry = std::pair<K, V>;
+
+  std::list<Entry> order;
+  std::unordered_map<K, typename std::list<Entry>::iterator, Hash> index;
+};
+
+/// How a cache key holds an argument of type `A`: by value, except that a C
+/// string or string view is copied into a `std::string`. `ParseTuple` points
+/// those into the argument object, which the cache must not outlive.
+template<typename A>
+struct KeyOf
+{
+  static_assert(!std::is_pointer<A>::value,
+                "Memoize cannot key on a pointer argument");
+  using type = A;
+};
+
+template<>
+struct KeyOf<const char *>
+{
+  using type = std::string;
+};
+
+#if __cplusplus >= 201703L
+template<>
+struct KeyOf<std::string_view>
+{
+  using type = std::string;
+};
+#endif
+
+template<typename Args>
+struct KeyTuple;
+
+template<typename...A>
+struct KeyTuple<std::tuple<A...>>
+{
+  using type = std::tuple<typename KeyOf<A>::type...>;
+};
+
+/// An opt-in cache for a function bound with `Bound`, keyed on the unboxed
+/// C++ arguments, so a hit costs one `ParseTuple` and one `box`. Each
+/// function gets its own cache of `Capacity` entries.
+///
+/// Python sees three functions, in the style of `functools.lru_cache`:
+///
+///   static PyMethodDef methods[] = {
+///     Py::MethodDef("fib", "...", PYXX_MEMOIZE(fib, 256)::call),
+///     Py::MethodDef("fib_cache_info", "...", PYXX_MEMOIZE(fib, 256)::info),
+///     Py::MethodDef("fib_cache_clear", "...", PYXX_MEMOIZE(fib, 256)::clear),
+///     ...
+///
+/// `info()` returns `(hits, misses, maxsize, currsize)`. `clear()` drops
+/// everything and resets the counters; `clear(*args)` drops just the entry
+/// for `args` and returns whether there was one.
+///
+/// Only use it for pure functions: a hit never calls `f`. Arguments are
+/// compared by value, so `f` cannot take pointers other than `const char *`.
+/// The cache lock is never held while Python code can run.
+template<typename F, F f, size_t Capacity = 128>
+struct Memoize
+{
+  using Fn    = Bound<F, f>;
+  using Args  = typename Fn::Args;
+  using Key   = typename KeyTuple<Args>::type;
+  using Value = std::decay_t<typename Fn::Result>;
+  using Cache = LruCache<Key, Value, TupleHash>;
+
+  static Cache &cache()
+  {
+    static Cache c(Capacity);
+    return c;
+  }
+
+  /// Only held around the cache itself: boxing can run a finalizer that
+  /// calls back in.
+  static AttachedMutex &mutex()
+  {
+    static AttachedMutex m;
+    return m;
+  }
+
+  static PyObject *call(PyObject *, PyObject *args)
+  {
+    Args xs;
+    if (!Fn::parse(args, xs))
+      return nullptr;
+
+    Key k(xs);
+    {
+      std::unique_lock<AttachedMutex> lock(mutex());
+      if (const Value *v = cache().find(k)) {
+        Value hit(*v);
+        lock.unlock();
+        return box(hit);
+      }
+    }
+
+    // Computed unlocked, so a slow call does not hold up hits on other keys.
+    Value v = Fn::apply(xs);
+    PyObject *o = box(v);
+    if (o) {
+      std::lock_guard<AttachedMutex> lock(mutex());
+      cache().insert(k, std::move(v));
+    }
+    return o;
+  }
+
+  static PyObject *info(PyObject *, PyObject *)
+  {
+    Py_ssize_t hits, misses, size;
+    {
+      std::lock_guard<AttachedMutex> lock(mutex());
+      Cache &c = cache();
+      hits = c.hits;
+      misses = c.misses;
+      size = c.size();
+    }
+    return Py_BuildValue("(nnnn)", hits, misses, (Py_ssize_t) Capacity, size);
+  }
+
+  static PyObject *clear(PyObject *, PyObject *args)
+  {
+    if (PyTuple_GET_SIZE(args) == 0) {
+      std::lock_guard<AttachedMutex> lock(mutex());
+      cache().clear();
+      Py_RETURN_NONE;
+    }
+
+    Args xs;
+    if (!Fn::parse(args, xs))
+      return nullptr;
+    Key k(xs);
+    bool erased;
+    {
+      std::lock_guard<AttachedMutex> lock(mutex());
+      erased = cache().erase(k);
+    }
+    return Object(erased).release();
+  }
+};
+
+#define PYXX_MEMOIZE(f, capacity) ::Py::Memoize<decltype(&f), &f, capacity>
+
+}  // namespace py
+
+#endif  // PYXX_MEMO_H
@@ -0,0 +1,324 @@
+
+#ifndef PYXX_MEMORY_H
+#define PYXX_MEMORY_H
+
+#include <Python.h>
+
+#include <atomic>
+#include <climits>
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "Py/Compat.h"
+
+namespace Py {
+
+/// Marks the unspecialized `HeapSize`, for `owns_heap`.
+struct NoHeapSize { };
+
+/// The heap bytes a `T` owns beyond `sizeof(T)`, for `__sizeof__`.
+///
+/// Specialize it, or give `T` a `size_t heap_size() const`, to count a
+/// type's own allocations. Standard containers count their capacity, and
+/// their elements' heap bytes in turn. Node sizes are estimates.
+template<typename T, typename = void>
+struct HeapSize : NoHeapSize
+{
+  static size_t of(const T &) { return 0; }
+};
+
+template<typename T>
+size_t heap_size(const T &x)
+{
+  return HeapSize<T>::of(x);
+}
+
+template<typename T>
+struct HeapSize<T, decltype((void) std::declval<const T &>().heap_size())>
+{
+  static size_t of(const T &x) { return x.heap_size(); }
+};
+
+/// Whether `HeapSize` counts anything for `T`.
+template<typename T>
+constexpr bool owns_heap()
+{
+  return !std::is_base_of<NoHeapSize, HeapSize<T>>::value;
+}
+
+/// Whether counting `T`s' heap bytes means visiting each one.
+template<typename T>
+constexpr bool may_own_heap()
+{
+  return !std::is_arithmetic<T>::value && !std::is_pointer<T>::value &&
+         !std::is_enum<T>::value;
+}
+
+template<typename C>
+size_t elements_heap_size(const C &c)
+{
+  using V = typename C::value_type;
+  size_t n = 0;
+  if (may_own_heap<V>())
+    for (const V &x : c)
+      n += heap_size(x);
+  return n;
+}
+
+template<typename U, typename A>
+struct HeapSize<std::vector<U, A>>
+{
+  static size_t of(const std::vector<U, A> &v)
+  {
+    if (std::is_same<U, bool>::value)
+      return (v.capacity() + CHAR_BIT - 1) / CHAR_BIT;
+    return v.capacity() * sizeof(U) + elements_heap_size(v);
+  }
+};
+
+template<typename C, typename Tr, typename A>
+struct HeapSize<std::basic_string<C, Tr, A>>
+{
+  static size_t of(const std::basic_string<C, Tr, A> &s)
+  {
+    // Short strings live inside the object itself.
+    const char *p = (const char *) s.data();
+    if (p >= (const char *) &s && p < (const char *) (&s + 1))
+      return 0;
+    return (s.capacity() + 1) * sizeof(C);
+  }
+};
+
+template<typename U, typename A>
+struct HeapSize<std::deque<U, A>>
+{
+  static size_t of(const std::deque<U, A> &d)
+  {
+    return d.size() * sizeof(U) + elements_heap_size(d);
+  }
+};
+
+template<typename U, typename A>
+struct HeapSize<std::list<U, A>>
+{
+  static size_t of(const std::list<U, A> &l)
+  {
+    return l.size() * (sizeof(U) + 2 * sizeof(void *)) +
+           elements_heap_size(l);
+  }
+};
+
+/// Red-black tree nodes: three links and a color beside each value.
+template<typename C>
+size_t tree_heap_size(const C &c)
+{
+  using V = typename C::value_type;
+  return c.size() * (sizeof(V) + 4 * sizeof(void *)) + elements_heap_size(c);
+}
+
+/// Hash nodes hold a link and a cached hash, plus one pointer per bucket.
+template<typename C>
+size_t hash_heap_size(const C &c)
+{
+  using V = typename C::value_type;
+  return c.bucket_count() * sizeof(void *) +
+         c.size() * (sizeof(V) + 2 * sizeof(void *)) + elements_heap_size(c);
+}
+
+template<typename K, typename V, typename Cmp, typename A>
+struct HeapSize<std::map<K, V, Cmp, A>>
+{
+  static size_t of(const std::map<K, V, Cmp, A> &m)
+  {
+    return tree_heap_size(m);
+  }
+};
+
+template<typename K, typename Cmp, typename A>
+struct HeapSize<std::set<K, Cmp, A>>
+{
+  static size_t of(const std::set<K, Cmp, A> &s) { return tree_heap_size(s); }
+};
+
+template<typename K, typename V, typename H, typename Eq, typename A>
+struct HeapSize<std::unordered_map<K, V, H, Eq, A>>
+{
+  static size_t of(const std::unordered_map<K, V, H, Eq, A> &m)
+  {
+    return hash_heap_size(m);
+  }
+};
+
+template<typename K, typename H, typename Eq, typename A>
+struct HeapSize<std::unordered_set<K, H, Eq, A>>
+{
+  static size_t of(const std::unordered_set<K, H, Eq, A> &s)
+  {
+    return hash_heap_size(s);
+  }
+};
+
+template<typename K, typename V>
+struct HeapSize<std::pair<K, V>>
+{
+  static size_t of(const std::pair<K, V> &p)
+  {
+    return heap_size(p.first) + heap_size(p.second);
+  }
+};
+
+template<typename U, typename D>
+struct HeapSize<std::unique_ptr<U, D>>
+{
+  static size_t of(const std::unique_ptr<U, D> &p)
+  {
+    return p ? sizeof(U) + heap_size(*p) : 0;
+  }
+};
+
+/// Process-wide counts for one `Extention<T>` type, kept by its `tp_alloc`
+/// and `tp_free` with relaxed atomics.
+///
+/// For types whose values may own heap memory, `objects` also holds every
+/// live object made by the default `tp_new` and freed by the default
+/// `tp_dealloc`, so `type_stats` can add up what they own.
+struct TypeStats
+{
+  PyTypeObject *type;
+  std::atomic<Py_ssize_t> live{0};
+  std::atomic<Py_ssize_t> created{0};
+
+  /// The heap bytes one object owns, or null if the type never owns any.
+  size_t (*heap)(PyObject *);
+  AttachedMutex objects_mutex;
+  std::unordered_set<PyObject *> objects;
+
+  TypeStats(PyTypeObject *type, size_t (*heap)(PyObject *))
+    : type(type), heap(heap)
+  {
+  }
+
+  void allocated() noexcept
+  {
+    live.fetch_add(1, std::memory_order_relaxed);
+    created.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void freed() noexcept { live.fetch_sub(1, std::memory_order_relaxed); }
+
+  /// Adds a fully constructed object to `objects`. Running out of memory
+  /// here only leaves it uncounted.
+  void track(PyObject *o) noexcept
+  {
+    if (!heap)
+      return;
+    std::lock_guard<AttachedMutex> lock(objects_mutex);
+    try {
+      objects.insert(o);
+    } catch (...) {
+    }
+  }
+
+  /// Removes `o` before its value is destroyed.
+  void untrack(PyObject *o) noexcept
+  {
+    if (!heap)
+      return;
+    std::lock_guard<AttachedMutex> lock(objects_mutex);
+    objects.erase(o);
+  }
+
+  /// The heap bytes every tracked object owns, each read under its lock.
+  size_t heap_bytes()
+  {
+    if (!heap)
+      return 0;
+    std::lock_guard<AttachedMutex> lock(objects_mutex);
+    size_t n = 0;
+    for (PyObject *o : objects) {
+      CriticalSection cs(o);
+      n += heap(o);
+    }
+    return n;
+  }
+
+  /// Every type's counts. They are never freed, so pointers stay valid.
+  static std::vector<TypeStats *> &all()
+  {
+    static std::vector<TypeStats *> v;
+    return v;
+  }
+
+  static std::mutex &mutex()
+  {
+    static std::mutex m;
+    return m;
+  }
+
+  static TypeStats *add(PyTypeObject *type, size_t (*heap)(PyObject *))
+  {
+    TypeStats *s = new TypeStats(type, heap);
+    std::lock_guard<std::mutex> lock(mutex());
+    all().push_back(s);
+    return s;
+  }
+};
+
+/// A module function reporting every `Extention` type's counts, as
+/// `{type name: (live, created, live bytes)}`. Live bytes are each live
+/// object's `tp_basicsize` plus the heap its value owns, as `__sizeof__`
+/// counts it.
+///
+///   Py::MethodDef("type_stats", "...", Py::type_stats),
+inline PyObject *type_stats(PyObject *, PyObject *)
+{
+  PyObject *d = PyDict_New();
+  if (!d)
+    return nullptr;
+
+  // Only the list is copied under the lock: walking each type's objects
+  // takes their locks, and may wait on other threads.
+  std::vector<TypeStats *> all;
+  {
+    std::lock_guard<std::mutex> lock(TypeStats::mutex());
+    all = TypeStats::all();
+  }
+
+  for (TypeStats *s : all) {
+    if (!s->type->tp_name)
+      continue;
+    Py_ssize_t live = s->live.load(std::memory_order_relaxed);
+    Py_ssize_t created = s->created.load(std::memory_order_relaxed);
+    Py_ssize_t bytes = live * s->type->tp_basicsize + s->heap_bytes();
+
+    // Types that share a name, like two unnamed `Array<T>`s, add up.
+    PyObject *old = PyDict_GetItemString(d, s->type->tp_name);
+    if (old) {
+      live += PyNumber_AsSsize_t(PyTuple_GET_ITEM(old, 0), nullptr);
+      created += PyNumber_AsSsize_t(PyTuple_GET_ITEM(old, 1), nullptr);
+      bytes += PyNumber_AsSsize_t(PyTuple_GET_ITEM(old, 2), nullptr);
+    }
+
+    PyObject *t = Py_BuildValue("(nnn)", live, created, bytes);
+    if (!t || PyDict_SetItemString(d, s->type->tp_name, t) < 0) {
+      Py_XDECREF(t);
+      Py_DECREF(d);
+      return nullptr;
+    }
+    Py_DECREF(t);
+  }
+  return d;
+}
+
+}  // namespace py
+
+#endif  // PYXX_MEMORY_H
@@ -0,0 +1,55 @@
+
+#ifndef PYXX_MODULE_H
+#define PYXX_MODULE_H
+
+#include <Python.h>
+
+#include "Py/Compat.h"
+
+/// Defines the entry point of module `name`.
+///
+/// `exec` readies the module's types and adds its objects, returning -1 with
+/// an exception set on failure. Python 3 uses multi-phase initialization and
+/// declares the module safe to run without the GIL; Python 2 runs `exec`
+/// right after `Py_InitModule`.
+///
+///   static int exec_spam(PyObject *m) { ... }
+///   PYXX_MODULE(spam, spamMethods, exec_spam)
+#if PYXX_PY3
+
+#ifdef Py_mod_gil
+# define PYXX_MOD_GIL_SLOT {Py_mod_gil, Py_MOD_GIL_NOT_USED},
+#else
+# define PYXX_MOD_GIL_SLOT
+#endif
+
+#define PYXX_MODULE(name, methods, exec)                                       \
+  static PyModuleDef_Slot name##_slots[] = {                                   \
+    {Py_mod_exec, (void *) (int (*)(PyObject *)) (exec)},                      \
+    PYXX_MOD_GIL_SLOT                                                          \
+    {0, NULL}                                                                  \
+  };                                                                           \
+                                                                               \
+  static PyModuleDef name##_def = {                                            \
+    PyModuleDef_HEAD_INIT, #name, NULL, 0, methods, name##_slots,              \
+    NULL, NULL, NULL                                                           \
+  };                                                                           \
+                                                                               \
+  PyMODINIT_FUNC PyInit_##name()                                               \
+  {                                                                            \
+    return PyModuleDef_Init(&name##_def);                                      \
+  }
+
+#else
+
+#define PYXX_MODULE(name, methods, exec)                                       \
+  PyMODINIT_FUNC init##name()                                                  \
+  {                                                                            \
+    PyObject *m = Py_InitModule(#name, methods);                               \
+    if (m)                                                                     \
+      exec(m);                                                                 \
+  }
+
+#endif
+
+#endif  // PYXX_MODULE_H
@@ -4,6 +4,11 @@
 
 #include <Python.h>
 
+#include <string>
+#include <complex>
+
+#include "Py/Compat.h"
+
 namespace Py {
 
 struct Object
@@ -24,24 +29,30 @@ struct Object
   explicit Object(bool b)       noexcept : Object(b ? Py_True : Py_False) { }
 
   // Strings
-  explicit Object(const char *s) noexcept { self = PyString_FromString(s); }
+  explicit Object(const char *s) noexcept { self = StringFromString(s); }
   explicit Object(const std::string &s) noexcept : Object(s.c_str()) { }
   explicit Object(const char *s, Py_ssize_t size) noexcept {
-    self = PyString_FromStringAndSize(s, size);
+    self = StringFromStringAndSize(s, size);
   }
   explicit Object(const std::string &s, Py_ssize_t size) noexcept
     : Object(s.c_str(), size) {
   }
 
   // Unicode
+#if PYXX_PY3
+  explicit Object(const wchar_t *s, Py_ssize_t size) noexcept {
+    self = PyUnicode_FromWideChar(s, size);
+  }
+#else
   explicit Object(const Py_UNICODE *s, Py_ssize_t size) noexcept {
     self = PyUnicode_FromUnicode(s, size);
   }
+#endif
 
   // Python numbers
-  explicit Object(size_t x)             noexcept { self = PyInt_FromSize_t(x); }
-  explicit Object(Py_ssize_t x)         noexcept { self = PyInt_FromSsize_t(x); }
-  explicit Object(int x)                noexcept { self = PyInt_FromLong(x); }
+  explicit Object(size_t x)             noexcept { self = IntFromSize_t(x); }
+  explicit Object(Py_ssize_t x)         noexcept { self = IntFromSsize_t(x); }
+  explicit Object(int x)                noexcept { self = IntFromLong(x); }
   explicit Object(long long x)          noexcept { self = PyLong_FromLongLong(x); }
   explicit Object(unsigned long long x) noexcept { self = PyLong_FromUnsignedLongLong(x); }
   explicit Object(double x)             noexcept { self = PyFloat_FromDouble(x); }
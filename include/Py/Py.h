@@ -12,6 +12,8 @@
 
 #include "Py/Object.h"
 #include "Py/Extention.h"
+#include "Py/Module.h"
+#include "Py/Trace.h"
 
 namespace Py {
 
@@ -38,23 +40,36 @@ constexpr bool is_PyCFunction(PyCFunction) {
 
 template<typename F>
 constexpr int MethodType(F f) {
-  return arity(f) == 3     ? METH_KEYWORDS
+  return arity(f) == 3     ? METH_VARARGS | METH_KEYWORDS
        : is_PyCFunction(f) ? METH_VARARGS
                            : METH_O;
 }
 
+/// Traced builds wrap each function as it is registered, which can't be
+/// done at compile time.
+#ifdef PYXX_TRACE
+# define PYXX_REGISTER_CONSTEXPR
+#else
+# define PYXX_REGISTER_CONSTEXPR constexpr
+#endif
+
 template<typename F>
-constexpr PyMethodDef MethodDef(const char *name, const char *doc,
-                                 int type, F f)
+PYXX_REGISTER_CONSTEXPR PyMethodDef MethodDef(const char *name,
+                                              const char *doc, int type, F f)
 {
   static_assert(arity(F()) == 2 || arity(F()) == 3,
                 "Methods must have an arity of 2 or 3");
   static_assert(returns_PyObject(F()), "Methods must return a PyObject *.");
+#ifdef PYXX_TRACE
+  return {name, traced_method(name, type, (PyCFunction)f), type, doc};
+#else
   return {name, (PyCFunction)f, type, doc};
+#endif
 }
 
 template<typename F>
-constexpr PyMethodDef MethodDef(const char *name, const char *doc, const F f)
+PYXX_REGISTER_CONSTEXPR PyMethodDef MethodDef(const char *name,
+                                              const char *doc, const F f)
 {
   return MethodDef(name, doc, MethodType(f), f);
 }
@@ -72,6 +87,9 @@ void Register(initproc &proc, F f)
   static_assert(is_object_method(F()),
                 "First argument must be PyObject-compatible.");
   proc = (initproc) f;
+#ifdef PYXX_TRACE
+  proc = TracePool<initproc>::wrap("__init__", nullptr, proc);
+#endif
 }
 
 template<typename F>
@@ -81,6 +99,9 @@ void Register(reprfunc &proc, F f)
   static_assert(is_object_method(F()),
                 "First argument must be PyObject-compatible.");
   proc = (reprfunc) f;
+#ifdef PYXX_TRACE
+  proc = TracePool<reprfunc>::wrap("__repr__", nullptr, proc);
+#endif
 }
 
 
@@ -0,0 +1,216 @@
+
+#ifndef PYXX_RECLAIM_H
+#define PYXX_RECLAIM_H
+
+#include <Python.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#ifndef _WIN32
+# include <pthread.h>
+#endif
+
+#include "Py/Memory.h"
+#include "Py/Thread.h"
+
+namespace Py {
+
+/// Whether an `Extention<T>`'s value is destroyed on a background thread,
+/// rather than by whichever thread drops the last reference. Off unless
+/// specialized:
+///
+///   template<> struct Py::ReclaimPolicy<Mesh> : Py::ReclaimAbove<1 << 20> { };
+///
+/// Only opt in types whose destructor never touches Python: no `Object`s,
+/// no callbacks. The object itself is still freed, and its type's counts
+/// updated, on the spot.
+template<typename T>
+struct ReclaimPolicy : std::false_type { };
+
+/// Reclaims values whose `Py::heap_size` is at least `Bytes` in the
+/// background. With 0, every value is, and none is measured, which saves
+/// walking a nested container twice.
+template<size_t Bytes = (1 << 20)>
+struct ReclaimAbove : std::true_type
+{
+  static constexpr size_t threshold = Bytes;
+};
+
+/// A value waiting to be destroyed.
+struct Garbage
+{
+  virtual ~Garbage() = default;
+};
+
+template<typename T>
+struct GarbageOf : Garbage
+{
+  T value;
+
+  explicit GarbageOf(T &&x) : value(std::move(x)) { }
+};
+
+/// One thread that destroys what it is handed, in order. The queue is
+/// bounded: when it is full, `offer` refuses and the caller destroys the
+/// value itself, so the memory waiting here stays bounded and a thread
+/// that frees faster than the reclaimer keeps up is slowed to its pace.
+struct Reclaimer
+{
+  explicit Reclaimer(size_t capacity = 64) : capacity(capacity) { }
+
+  Reclaimer(const Reclaimer &) = delete;
+  Reclaimer &operator= (const Reclaimer &) = delete;
+
+  /// Queues `g`, or returns false, leaving it with the caller, if the
+  /// queue is full or there is no thread to hand it to.
+  bool offer(std::unique_ptr<Garbage> &g) noexcept
+  {
+    try {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (queue.size() >= capacity || !start())
+        return false;
+      queue.push_back(std::move(g));
+    } catch (...) {
+      return false;
+    }
+    ready.notify_one();
+    return true;
+  }
+
+  /// Waits until everything queued so far is destroyed.
+  void wait()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!queue.empty() && !start()) {
+      // There is no worker to wait for (as in a child forked with values
+      // queued), so destroy the rest here.
+      std::deque<std::unique_ptr<Garbage>> rest;
+      rest.swap(queue);
+      lock.unlock();
+      return;
+    }
+    idle.wait(lock, [this] { return queue.empty() && !busy; });
+  }
+
+  /// The reclaimer `Extention` types use. It is never destroyed, so that
+  /// exiting does not wait on it; whatever is still queued then leaks.
+  static Reclaimer &global()
+  {
+    static Reclaimer *r = make_global();
+    return *r;
+  }
+
+private:
+  const size_t capacity;
+  std::mutex mutex;
+  std::condition_variable ready, idle;
+  std::deque<std::unique_ptr<Garbage>> queue;
+  std::thread worker;
+  bool busy = false;
+
+  /// Starts the worker if there is none. With the lock held.
+  bool start()
+  {
+    if (worker.joinable())
+      return true;
+    try {
+      worker = std::thread([this] { work(); });
+    } catch (...) {
+      return false;
+    }
+    return true;
+  }
+
+  static Reclaimer *make_global()
+  {
+    Reclaimer *r = new Reclaimer;
+#ifndef _WIN32
+    // A forked child has only the forking thread, so the worker it
+    // inherits the handle of is gone. Fork with the lock held, so the
+    // child gets a consistent queue, then forget the old worker there.
+    pthread_atfork(
+      [] { global().mutex.lock(); },
+      [] { global().mutex.unlock(); },
+      [] {
+        Reclaimer &r = global();
+        new (&r.mutex) std::mutex;
+        new (&r.ready) std::condition_variable;
+        new (&r.idle) std::condition_variable;
+        new (&r.worker) std::thread;
+        r.busy = false;
+      });
+#endif
+    return r;
+  }
+
+  void work()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+      ready.wait(lock, [this] { return !queue.empty(); });
+      std::unique_ptr<Garbage> g = std::move(queue.front());
+      queue.pop_front();
+      busy = true;
+      lock.unlock();
+      g.reset();
+      lock.lock();
+      busy = false;
+      if (queue.empty())
+        idle.notify_all();
+    }
+  }
+};
+
+/// Destroys `x` in place, as `tp_dealloc` does.
+template<typename T>
+void destroy_value(T &x, std::false_type)
+{
+  x.T::~T();
+}
+
+/// Moves `x` out to the reclaimer when its policy says to, then destroys
+/// what is left, which for a container is empty.
+template<typename T>
+void destroy_value(T &x, std::true_type)
+{
+  static_assert(alignof(T) <= alignof(std::max_align_t),
+                "Over-aligned values can't be reclaimed in the background.");
+  constexpr size_t threshold = ReclaimPolicy<T>::threshold;
+  if (threshold == 0 || heap_size(x) >= threshold) {
+    std::unique_ptr<Garbage> g(new (std::nothrow) GarbageOf<T>(std::move(x)));
+    if (g)
+      Reclaimer::global().offer(g);
+  }
+  x.T::~T();
+}
+
+template<typename T>
+void destroy_value(T &x)
+{
+  destroy_value(x, std::integral_constant<bool, ReclaimPolicy<T>::value>());
+}
+
+/// A module function that waits, without the GIL, until every value
+/// queued for background destruction so far is gone.
+///
+///   Py::MethodDef("reclaim_wait", "...", Py::reclaim_wait),
+inline PyObject *reclaim_wait(PyObject *, PyObject *)
+{
+  {
+    AllowThreads nogil;
+    Reclaimer::global().wait();
+  }
+  Py_RETURN_NONE;
+}
+
+}  // namespace py
+
+#endif  // PYXX_RECLAIM_H
@@ -0,0 +1,251 @@
+
+#ifndef PYXX_SORT_H
+#define PYXX_SORT_H
+
+#include <Python.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "Py/Compat.h"
+#include "Py/Object.h"
+
+namespace Py {
+
+/// What every element of a sequence is, when it is all one kind that can be
+/// compared without calling back into Python.
+enum class SortKind { Generic, Int, Float, Str };
+
+/// Reads each element's type once. Only exact types count, since subclasses
+/// may override their comparisons.
+inline SortKind sort_kind(PyObject *const *xs, Py_ssize_t n)
+{
+  if (n == 0)
+    return SortKind::Generic;
+
+  auto all = [&](bool (*is)(PyObject *)) {
+    for (Py_ssize_t i = 0; i < n; i++)
+      if (!is(xs[i]))
+        return false;
+    return true;
+  };
+
+#if PYXX_PY3
+  if (all([](PyObject *o) -> bool { return PyLong_CheckExact(o); }))
+    return SortKind::Int;
+  if (all([](PyObject *o) -> bool { return PyUnicode_CheckExact(o); }))
+    return SortKind::Str;
+#else
+  if (all([](PyObject *o) -> bool {
+        return PyInt_CheckExact(o) || PyLong_CheckExact(o);
+      }))
+    return SortKind::Int;
+  if (all([](PyObject *o) -> bool { return PyString_CheckExact(o); }))
+    return SortKind::Str;
+#endif
+  if (all([](PyObject *o) -> bool { return PyFloat_CheckExact(o); }))
+    return SortKind::Float;
+  return SortKind::Generic;
+}
+
+using RadixItem = std::pair<uint64_t, Py_ssize_t>;
+
+/// A stable LSD radix sort on the keys, a byte at a time. Passes where every
+/// key has the same byte are skipped, so small integers take one or two.
+inline void radix_sort(std::vector<RadixItem> &v)
+{
+  std::vector<RadixItem> tmp(v.size());
+  for (int shift = 0; shift < 64; shift += 8) {
+    size_t count[257] = { };
+    for (const RadixItem &x : v)
+      count[((x.first >> shift) & 0xff) + 1]++;
+    if (count[((v[0].first >> shift) & 0xff) + 1] == v.size())
+      continue;
+
+    for (int b = 0; b < 256; b++)
+      count[b + 1] += count[b];
+    for (const RadixItem &x : v)
+      tmp[count[(x.first >> shift) & 0xff]++] = x;
+    v.swap(tmp);
+  }
+}
+
+/// Maps an integer onto an unsigned key with the same order.
+inline uint64_t radix_key(long long x)
+{
+  return (uint64_t) x ^ (uint64_t(1) << 63);
+}
+
+/// Maps a double that isn't NaN onto an unsigned key with the same order.
+/// -0.0 and 0.0 compare equal, so they get the same key to keep the sort
+/// stable between them.
+inline uint64_t radix_key(double d)
+{
+  if (d == 0)
+    d = 0;
+  uint64_t b;
+  std::memcpy(&b, &d, sizeof b);
+  return (b >> 63) ? ~b : b | (uint64_t(1) << 63);
+}
+
+/// Reads an exact int (or, on Python 2, long) as a `long long`. Returns
+/// false, with no exception set, if it doesn't fit.
+inline bool sort_int(PyObject *o, long long &x)
+{
+#if !PYXX_PY3
+  if (PyInt_CheckExact(o)) {
+    x = PyInt_AS_LONG(o);
+    return true;
+  }
+#endif
+  int overflow;
+  x = PyLong_AsLongLongAndOverflow(o, &overflow);
+  return !overflow && !(x == -1 && PyErr_Occurred());
+}
+
+/// Fills `order` with the indices of `keys` in sorted order, stably, without
+/// comparing any two Python objects. Returns false, with no exception set,
+/// if the keys need the generic path: mixed types, ints too big for 64
+/// bits, NaNs, or strings that have no UTF-8 form.
+inline bool unboxed_order(PyObject *const *keys, Py_ssize_t n,
+                          std::vector<Py_ssize_t> &order)
+{
+  SortKind kind = sort_kind(keys, n);
+  if (kind == SortKind::Generic)
+    return false;
+
+  order.resize(n);
+  if (kind == SortKind::Str) {
+    struct Str { const char *s; Py_ssize_t len; Py_ssize_t i; };
+    std::vector<Str> v(n);
+    for (Py_ssize_t i = 0; i < n; i++) {
+#if PYXX_PY3
+      // UTF-8 orders the same as code points, which is how str compares.
+      v[i].s = PyUnicode_AsUTF8AndSize(keys[i], &v[i].len);
+      if (!v[i].s) {
+        PyErr_Clear();
+        return false;
+      }
+#else
+      v[i].s = PyString_AS_STRING(keys[i]);
+      v[i].len = PyString_GET_SIZE(keys[i]);
+#endif
+      v[i].i = i;
+    }
+    std::stable_sort(v.begin(), v.end(), [](const Str &a, const Str &b) {
+      int c = std::memcmp(a.s, b.s, std::min(a.len, b.len));
+      return c < 0 || (c == 0 && a.len < b.len);
+    });
+    for (Py_ssize_t i = 0; i < n; i++)
+      order[i] = v[i].i;
+    return true;
+  }
+
+  std::vector<RadixItem> v(n);
+  for (Py_ssize_t i = 0; i < n; i++) {
+    if (kind == SortKind::Int) {
+      long long x;
+      if (!sort_int(keys[i], x)) {
+        PyErr_Clear();
+        return false;
+      }
+      v[i] = RadixItem(radix_key(x), i);
+    } else {
+      double d = PyFloat_AS_DOUBLE(keys[i]);
+      if (std::isnan(d))
+        return false;
+      v[i] = RadixItem(radix_key(d), i);
+    }
+  }
+  radix_sort(v);
+  for (Py_ssize_t i = 0; i < n; i++)
+    order[i] = v[i].second;
+  return true;
+}
+
+/// The generic path for `order`: a stable sort with `<` on the keys.
+/// Returns false with an exception set if a comparison raised.
+inline bool generic_order(PyObject *const *keys, Py_ssize_t n,
+                          std::vector<Py_ssize_t> &order)
+{
+  order.resize(n);
+  for (Py_ssize_t i = 0; i < n; i++)
+    order[i] = i;
+
+  bool failed = false;
+  std::stable_sort(order.begin(), order.end(),
+                   [&](Py_ssize_t a, Py_ssize_t b) {
+    if (failed)
+      return false;
+    int lt = PyObject_RichCompareBool(keys[a], keys[b], Py_LT);
+    if (lt < 0)
+      failed = true;
+    return lt > 0;
+  });
+  return !failed;
+}
+
+/// Sorts `list` in place like `list.sort()`, but compares all-int,
+/// all-float and all-str contents unboxed: integers and floats by a radix
+/// sort on their bits, strings by their bytes. Only the object pointers
+/// move; no references change hands. Anything else goes to `PyList_Sort`.
+///
+/// With a `key`, each key is computed once, as `list.sort(key=key)` does,
+/// and the same rules apply to the keys. Returns false with an exception set
+/// on failure, including if `key` changed the list.
+inline bool SortUnboxed(PyObject *list, PyObject *key = nullptr)
+{
+  CriticalSection lock(list);
+  Py_ssize_t n = PyList_GET_SIZE(list);
+  PyObject **items = ((PyListObject *) list)->ob_item;
+  std::vector<Py_ssize_t> order;
+
+  if (!key) {
+    if (!unboxed_order(items, n, order))
+      return PyList_Sort(list) == 0;
+  } else {
+    // The key function can run arbitrary code, so hold our own references
+    // to the items and check the list afterwards.
+    std::vector<Object> snapshot, keys;
+    snapshot.reserve(n);
+    keys.reserve(n);
+    for (Py_ssize_t i = 0; i < n; i++)
+      snapshot.emplace_back(items[i]);
+    for (Py_ssize_t i = 0; i < n; i++) {
+      keys.emplace_back(PyObject_CallFunctionObjArgs(key, snapshot[i].self,
+                                                     nullptr), true);
+      if (!keys.back().self)
+        return false;
+    }
+
+    std::vector<PyObject *> ks(n);
+    for (Py_ssize_t i = 0; i < n; i++)
+      ks[i] = keys[i].self;
+    if (!unboxed_order(ks.data(), n, order) &&
+        !generic_order(ks.data(), n, order))
+      return false;
+
+    items = ((PyListObject *) list)->ob_item;
+    bool same = PyList_GET_SIZE(list) == n;
+    for (Py_ssize_t i = 0; same && i < n; i++)
+      same = items[i] == snapshot[i].self;
+    if (!same) {
+      PyErr_SetString(PyExc_ValueError, "list modified during sort");
+      return false;
+    }
+  }
+
+  std::vector<PyObject *> sorted(n);
+  for (Py_ssize_t i = 0; i < n; i++)
+    sorted[i] = items[order[i]];
+  std::copy(sorted.begin(), sorted.end(), items);
+  return true;
+}
+
+}  // namespace py
+
+#endif  // PYXX_SORT_H
@@ -7,18 +7,19 @@
 #include <sstream>
 
 #include "Py/Object.h"
+#include "Py/Tuple.h"
 
 namespace Py {
 
 struct String : Object
 {
   explicit String(const char *str) noexcept
-    : Object(PyString_FromString(str), true)
+    : Object(StringFromString(str), true)
   {
   }
 
   explicit String(const char *str, Py_ssize_t size) noexcept
-    : Object(PyString_FromStringAndSize(str, size), true)
+    : Object(StringFromStringAndSize(str, size), true)
   {
   }
 
@@ -32,12 +33,12 @@ struct String : Object
 
   Py_ssize_t size() const noexcept
   {
-    return PyString_Size(self);
+    return StringSize(self);
   }
 
   const char *c_str() const noexcept
   {
-    return PyString_AsString(self);
+    return StringAsString(self);
   }
 
   const char *begin() const noexcept
@@ -52,13 +53,13 @@ struct String : Object
 
   String & operator += (String &s) noexcept
   {
-    PyString_Concat(&self, s);
+    StringConcat(&self, s);
     return *this;
   }
 
   String & operator += (String &&s) noexcept
   {
-    PyString_ConcatAndDel(&self, s.release());
+    StringConcatAndDel(&self, s.release());
     return *this;
   }
 };
@@ -66,9 +67,29 @@ struct String : Object
 template<typename...Args>
 String format(const char *fmt, Args*...args)
 {
-  return String(PyString_FromFormat(fmt, args...), true);
+  return String(StringFromFormat(fmt, args...), true);
 }
 
+/// Copies a `str` (or, on Python 2, a byte string) into a `std::string`,
+/// as UTF-8.
+template<>
+struct Converter<std::string>
+{
+  static int convert(PyObject *o, void *v)
+  {
+    if (!StringCheck(o)) {
+      PyErr_Format(PyExc_TypeError, "expected str, not %s",
+                   Py_TYPE(o)->tp_name);
+      return 0;
+    }
+    const char *s = StringAsString(o);
+    if (!s)
+      return 0;
+    ((std::string *) v)->assign(s, StringSize(o));
+    return 1;
+  }
+};
+
 } // namespace py
 
 #endif  // PYXX_STRING_H
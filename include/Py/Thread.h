@@ -0,0 +1,310 @@
+
+#ifndef PYXX_THREAD_H
+#define PYXX_THREAD_H
+
+#include <Python.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Py/Trace.h"
+
+namespace Py {
+
+/// Releases the GIL for the enclosing scope, like
+/// `Py_BEGIN_ALLOW_THREADS`/`Py_END_ALLOW_THREADS`. Nothing inside may touch
+/// a Python object.
+struct AllowThreads
+{
+  TraceScope trace;
+  PyThreadState *save;
+
+  AllowThreads() noexcept
+    : trace("nogil", "gil"), save(PyEval_SaveThread())
+  {
+  }
+
+  ~AllowThreads() noexcept
+  {
+    TraceScope wait("wait", "gil");
+    PyEval_RestoreThread(save);
+  }
+
+  AllowThreads(const AllowThreads &) = delete;
+  AllowThreads &operator= (const AllowThreads &) = delete;
+};
+
+/// Locks `m`. If another thread holds it, waits with the GIL released, so
+/// the holder can still take the GIL (or, on a free-threaded build, stop the
+/// world) without deadlocking against us.
+inline std::unique_lock<std::mutex> lock_detached(std::mutex &m)
+{
+  std::unique_lock<std::mutex> lock(m, std::try_to_lock);
+  if (!lock) {
+    AllowThreads nogil;
+    lock.lock();
+  }
+  return lock;
+}
+
+/// A fixed set of native threads that run jobs in submission order.
+///
+/// Workers never hold the GIL, so jobs must only touch C++ state. A job
+/// that throws is abandoned there and the worker carries on; `parallel_for`
+/// hands its body's exceptions back to the caller instead.
+struct ThreadPool
+{
+  explicit ThreadPool(unsigned n = std::thread::hardware_concurrency())
+  {
+    for (unsigned i = 0; i < (n ? n : 1); i++)
+      workers.emplace_back([this] { work(); });
+  }
+
+  ~ThreadPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    ready.notify_all();
+    for (std::thread &t : workers)
+      t.join();
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator= (const ThreadPool &) = delete;
+
+  void submit(std::function<void()> job)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      jobs.push_back(std::move(job));
+    }
+    ready.notify_one();
+  }
+
+  unsigned size() const noexcept { return workers.size(); }
+
+  /// The pool shared by the whole process. It is never destroyed, so that
+  /// exiting does not wait on a long job.
+  static ThreadPool &global()
+  {
+    static ThreadPool *pool = new ThreadPool;
+    return *pool;
+  }
+
+private:
+  std::mutex mutex;
+  std::condition_variable ready;
+  std::deque<std::function<void()>> jobs;
+  std::vector<std::thread> workers;
+  bool stopping = false;
+
+  void work()
+  {
+    for (;;) {
+      std::function<void()> job;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        ready.wait(lock, [this] { return stopping || !jobs.empty(); });
+        if (jobs.empty())
+          return;
+        job = std::move(jobs.front());
+        jobs.pop_front();
+      }
+      try {
+        job();
+      } catch (...) {
+      }
+    }
+  }
+};
+
+/// Runs `body(begin, end)` over `[0, n)` in chunks of at least `grain`,
+/// spread over `pool` and the calling thread. Returns once every chunk is
+/// done. The caller takes chunks too, so it finishes the work itself if the
+/// pool is busy, and nesting never deadlocks.
+///
+/// If `body` throws, chunks not yet started are skipped and, once every
+/// started one is done, the first exception is rethrown on the caller.
+template<typename F>
+void parallel_for(size_t n, size_t grain, F body,
+                  ThreadPool &pool = ThreadPool::global())
+{
+  if (grain == 0)
+    grain = 1;
+  size_t chunks = std::min<size_t>((n + grain - 1) / grain, pool.size() + 1);
+  if (chunks <= 1) {
+    if (n)
+      body(size_t(0), n);
+    return;
+  }
+
+  struct Shared {
+    std::atomic<size_t> next{0};
+    std::atomic<bool> failed{false};
+    size_t done = 0;
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::condition_variable finished;
+  };
+  auto shared = std::make_shared<Shared>();
+  size_t step = (n + chunks - 1) / chunks;
+
+  auto work = [=, &body] {
+    size_t c;
+    while ((c = shared->next++) < chunks) {
+      size_t begin = c * step, end = std::min(n, begin + step);
+      std::exception_ptr error;
+      if (begin < end && !shared->failed.load(std::memory_order_relaxed)) {
+        try {
+          body(begin, end);
+        } catch (...) {
+          error = std::current_exception();
+          shared->failed.store(true, std::memory_order_relaxed);
+        }
+      }
+      std::lock_guard<std::mutex> lock(shared->mutex);
+      if (error && !shared->error)
+        shared->error = error;
+      if (++shared->done == chunks)
+        shared->finished.notify_all();
+    }
+  };
+
+  // Helpers only reach `body` while a chunk is unclaimed, and the caller
+  // does not return until every claimed chunk is done, so `body` outlives
+  // every use of it. If the pool can't take a helper, the caller does its
+  // share.
+  try {
+    for (size_t i = 1; i < chunks; i++)
+      pool.submit(work);
+  } catch (...) {
+  }
+  work();
+
+  std::unique_lock<std::mutex> lock(shared->mutex);
+  shared->finished.wait(lock, [&] { return shared->done == chunks; });
+  if (shared->error)
+    std::rethrow_exception(shared->error);
+}
+
+/// Reduces `[0, n)` in parallel: `chunk(begin, end)` reduces one chunk of
+/// `grain` elements, and the chunks' results are folded with `combine`,
+/// pairwise, in order.
+///
+/// Chunks depend only on `n` and `grain`, never on the number of threads,
+/// so a floating-point sum gives the same bits on every machine, and the
+/// pairwise fold keeps its rounding error growing with log(n).
+template<typename T, typename F, typename C>
+T parallel_reduce(size_t n, size_t grain, T identity, F chunk, C combine,
+                  ThreadPool &pool = ThreadPool::global())
+{
+  if (grain == 0)
+    grain = 1;
+  size_t chunks = (n + grain - 1) / grain;
+  if (chunks == 0)
+    return identity;
+
+  std::vector<T> rs(chunks, identity);
+  parallel_for(chunks, 1, [&](size_t b, size_t e) {
+    for (size_t c = b; c < e; c++)
+      rs[c] = chunk(c * grain, std::min(n, (c + 1) * grain));
+  }, pool);
+
+  for (size_t step = 1; step < chunks; step *= 2)
+    for (size_t i = 0; i + step < chunks; i += 2 * step)
+      rs[i] = combine(rs[i], rs[i + step]);
+  return rs[0];
+}
+
+/// Sorts `[first, last)` by `comp`, in parallel once there is more than one
+/// `grain` of it: the chunks are sorted at once, then merged pairwise, a
+/// round of merges at a time. Like `std::sort`, it isn't stable.
+template<typename It, typename Comp>
+void parallel_sort(It first, It last, Comp comp, size_t grain,
+                   ThreadPool &pool = ThreadPool::global())
+{
+  size_t n = last - first;
+  if (grain == 0)
+    grain = 1;
+  size_t chunks = std::min<size_t>((n + grain - 1) / grain, pool.size() + 1);
+  if (chunks <= 1) {
+    std::sort(first, last, comp);
+    return;
+  }
+
+  std::vector<size_t> bound(chunks + 1);
+  for (size_t c = 0; c <= chunks; c++)
+    bound[c] = n * c / chunks;
+
+  parallel_for(chunks, 1, [&](size_t b, size_t e) {
+    for (size_t c = b; c < e; c++)
+      std::sort(first + bound[c], first + bound[c + 1], comp);
+  }, pool);
+
+  for (size_t width = 1; width < chunks; width *= 2) {
+    size_t pairs = (chunks + 2 * width - 1) / (2 * width);
+    parallel_for(pairs, 1, [&](size_t b, size_t e) {
+      for (size_t p = b; p < e; p++) {
+        size_t lo = 2 * width * p, mid = lo + width;
+        if (mid < chunks)
+          std::inplace_merge(first + bound[lo], first + bound[mid],
+                             first + bound[std::min(mid + width, chunks)],
+                             comp);
+      }
+    }, pool);
+  }
+}
+
+template<typename It>
+void parallel_sort(It first, It last, size_t grain,
+                   ThreadPool &pool = ThreadPool::global())
+{
+  parallel_sort(first, last, std::less<>(), grain, pool);
+}
+
+/// Writes the running totals of `in[0, n)` to `out`, so that `out[i]` is
+/// `in[0] + ... + in[i]`. Each chunk of `grain` is summed, the chunk totals
+/// are scanned, and then each chunk is scanned again from its offset, both
+/// passes in parallel. `out` may be `in`.
+template<typename T, typename U>
+void parallel_prefix_sum(const T *in, U *out, size_t n, size_t grain,
+                         ThreadPool &pool = ThreadPool::global())
+{
+  if (grain == 0)
+    grain = 1;
+  size_t chunks = (n + grain - 1) / grain;
+  std::vector<U> offset(chunks + 1, U());
+
+  parallel_for(chunks, 1, [&](size_t b, size_t e) {
+    for (size_t c = b; c < e; c++) {
+      U sum = U();
+      for (size_t i = c * grain, end = std::min(n, i + grain); i < end; i++)
+        sum += in[i];
+      offset[c + 1] = sum;
+    }
+  }, pool);
+  for (size_t c = 0; c < chunks; c++)
+    offset[c + 1] += offset[c];
+
+  parallel_for(chunks, 1, [&](size_t b, size_t e) {
+    for (size_t c = b; c < e; c++) {
+      U sum = offset[c];
+      for (size_t i = c * grain, end = std::min(n, i + grain); i < end; i++)
+        out[i] = sum += in[i];
+    }
+  }, pool);
+}
+
+}  // namespace py
+
+#endif  // PYXX_THREAD_H
@@ -0,0 +1,450 @@
+
+#ifndef PYXX_TRACE_H
+#define PYXX_TRACE_H
+
+#include <Python.h>
+#include <pythread.h>
+
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Py/Compat.h"
+
+/// Timeline tracing, for seeing when native calls run, overlap and wait on
+/// the GIL. Build a module with `-DPYXX_TRACE` to compile it in; without
+/// it, every hook below is empty.
+///
+/// Once compiled in, it records nothing until `trace_start()`. Functions
+/// registered with `Py::MethodDef` and `Py::Register`, `Extention`
+/// allocation and deallocation, and `AllowThreads` regions then log
+/// begin/end events, with their thread, into per-thread ring buffers.
+/// `trace_dump()` returns them as Chrome trace JSON, for chrome://tracing
+/// or Perfetto. Times are `steady_clock` microseconds, the same clock as
+/// `time.monotonic()` on Linux, to line up with Python-side spans.
+///
+/// Whether modules share one trace depends on how the platform links their
+/// copies of these statics (GCC on Linux merges them), so expose the
+/// functions from every traced module:
+///
+///   Py::MethodDef("trace_start", "...", Py::trace_start),
+///   Py::MethodDef("trace_stop", "...", Py::trace_stop),
+///   Py::MethodDef("trace_dump", "...", Py::trace_dump),
+
+namespace Py {
+
+#ifdef PYXX_TRACE
+
+struct TraceEvent
+{
+  const char *name;
+  const char *cat;
+  int64_t ns;
+  char phase;  // 'B'egin or 'E'nd.
+};
+
+/// One slot of a ring. `seq` is 2n+2 once event n is in it and odd while
+/// it is being written, so a reader can tell a torn or stale copy from
+/// a good one.
+struct TraceSlot
+{
+  std::atomic<uint64_t> seq{0};
+  std::atomic<const char *> name{nullptr};
+  std::atomic<const char *> cat{nullptr};
+  std::atomic<int64_t> ns{0};
+  std::atomic<char> phase{0};
+};
+
+/// One thread's recent events. Only that thread writes, so recording takes
+/// no lock; a reader copies the last `capacity` events and drops any the
+/// writer overwrote meanwhile.
+struct TraceRing
+{
+  static constexpr size_t capacity = 1 << 15;
+
+  std::atomic<uint64_t> head{0};
+  /// Events before this one were cleared. Only readers, and a thread
+  /// taking the ring over, move it, so a clear can't be undone by the writer.
+  std::atomic<uint64_t> floor{0};
+  TraceSlot slots[capacity];
+  // The rest are guarded by `Tracer::mutex()`.
+  int tid;
+  unsigned long ident;
+  bool exited = false;  // Its thread is gone.
+  bool seen = false;    // Dumped or cleared since then, so free to reuse.
+
+  TraceRing(int tid, unsigned long ident) : tid(tid), ident(ident) { }
+
+  void push(const TraceEvent &e) noexcept
+  {
+    uint64_t h = head.load(std::memory_order_relaxed);
+    TraceSlot &s = slots[h % capacity];
+    s.seq.store(2 * h + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    s.name.store(e.name, std::memory_order_relaxed);
+    s.cat.store(e.cat, std::memory_order_relaxed);
+    s.ns.store(e.ns, std::memory_order_relaxed);
+    s.phase.store(e.phase, std::memory_order_relaxed);
+    s.seq.store(2 * h + 2, std::memory_order_release);
+    head.store(h + 1, std::memory_order_release);
+  }
+
+  /// Copies event `n` into `e`, unless it was overwritten or is still
+  /// being written.
+  bool read(uint64_t n, TraceEvent &e) const noexcept
+  {
+    const TraceSlot &s = slots[n % capacity];
+    uint64_t before = s.seq.load(std::memory_order_acquire);
+    if (before != 2 * n + 2)
+      return false;
+    e.name = s.name.load(std::memory_order_relaxed);
+    e.cat = s.cat.load(std::memory_order_relaxed);
+    e.ns = s.ns.load(std::memory_order_relaxed);
+    e.phase = s.phase.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return s.seq.load(std::memory_order_relaxed) == before;
+  }
+};
+
+struct Tracer
+{
+  static std::atomic<bool> &enabled()
+  {
+    static std::atomic<bool> on{false};
+    return on;
+  }
+
+  static bool on() noexcept
+  {
+    return enabled().load(std::memory_order_relaxed);
+  }
+
+  static int64_t now() noexcept
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  static void record(const char *name, const char *cat, char phase) noexcept
+  {
+    TraceRing *r = ring();
+    if (r)
+      r->push(TraceEvent{name, cat, now(), phase});
+  }
+
+  /// Every thread's ring. Rings are never freed: a thread that exits
+  /// leaves its events to be dumped, and a later thread takes the ring over.
+  static std::vector<std::unique_ptr<TraceRing>> &rings()
+  {
+    static std::vector<std::unique_ptr<TraceRing>> v;
+    return v;
+  }
+
+  /// The rings of exited threads, oldest first.
+  static std::deque<TraceRing *> &exited()
+  {
+    static std::deque<TraceRing *> d;
+    return d;
+  }
+
+  /// Past this many exited rings that haven't been dumped or cleared, a new
+  /// thread takes over the oldest anyway, so churning threads can't grow
+  /// the trace without bound.
+  static constexpr size_t keep_exited = 16;
+
+  static std::mutex &mutex()
+  {
+    static std::mutex m;
+    return m;
+  }
+
+  /// The calling thread's ring, made or taken over on its first event.
+  static TraceRing *ring() noexcept
+  {
+    static thread_local Owner owner;
+    if (!owner.r)
+      owner.r = claim();
+    return owner.r;
+  }
+
+  /// Forgets every event recorded so far. Threads still recording carry
+  /// on after what was cleared.
+  static void clear()
+  {
+    std::lock_guard<std::mutex> lock(mutex());
+    for (auto &r : rings()) {
+      r->floor.store(r->head.load(std::memory_order_acquire),
+                     std::memory_order_relaxed);
+      r->seen = r->exited;
+    }
+  }
+
+  static void append_json(std::string &out, const char *s)
+  {
+    out += '"';
+    for (; *s; s++) {
+      if (*s == '"' || *s == '\\')
+        out += '\\';
+      if ((unsigned char) *s >= 0x20)
+        out += *s;
+    }
+    out += '"';
+  }
+
+  /// The recorded events, as a Chrome trace.
+  static std::string dump()
+  {
+    std::string out = "{\"traceEvents\":[";
+    bool first = true;
+    char buf[128];
+
+    std::lock_guard<std::mutex> lock(mutex());
+    for (auto &r : rings()) {
+      std::snprintf(buf, sizeof buf,
+                    "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,"
+                    "\"tid\":%d,\"args\":{\"name\":\"thread %lu\"}}",
+                    first ? "" : ",", r->tid, r->ident);
+      out += buf;
+      first = false;
+
+      // Anything the thread writes over while we read is dropped.
+      uint64_t end = r->head.load(std::memory_order_acquire);
+      uint64_t begin = std::max<uint64_t>(
+        end > TraceRing::capacity ? end - TraceRing::capacity : 0,
+        r->floor.load(std::memory_order_relaxed));
+      TraceEvent e;
+      for (uint64_t i = begin; i < end; i++) {
+        if (!r->read(i, e))
+          continue;
+        out += ",{\"name\":";
+        append_json(out, e.name);
+        out += ",\"cat\":";
+        append_json(out, e.cat);
+        std::snprintf(buf, sizeof buf,
+                      ",\"ph\":\"%c\",\"ts\":%lld.%03d,\"pid\":1,\"tid\":%d}",
+                      e.phase, (long long) (e.ns / 1000),
+                      (int) (e.ns % 1000), r->tid);
+        out += buf;
+      }
+      r->seen = r->exited;
+    }
+    out += "]}";
+    return out;
+  }
+
+private:
+  /// Hands the ring back when its thread exits.
+  struct Owner
+  {
+    TraceRing *r = nullptr;
+
+    ~Owner()
+    {
+      if (!r)
+        return;
+      std::lock_guard<std::mutex> lock(mutex());
+      try {
+        exited().push_back(r);
+        r->exited = true;
+        r->seen = false;
+      } catch (...) {
+        // Not reused, then; its events are still dumped.
+      }
+      r = nullptr;
+    }
+  };
+
+  static TraceRing *claim() noexcept
+  {
+    static int tids = 0;
+    std::lock_guard<std::mutex> lock(mutex());
+    std::deque<TraceRing *> &old = exited();
+    auto it = std::find_if(old.begin(), old.end(),
+                           [](TraceRing *r) { return r->seen; });
+    if (it == old.end() && old.size() > keep_exited)
+      it = old.begin();
+    if (it != old.end()) {
+      TraceRing *r = *it;
+      old.erase(it);
+      r->floor.store(r->head.load(std::memory_order_relaxed),
+                     std::memory_order_relaxed);
+      r->tid = ++tids;
+      r->ident = PyThread_get_thread_ident();
+      r->exited = r->seen = false;
+      return r;
+    }
+
+    try {
+      rings().reserve(rings().size() + 1);
+    } catch (...) {
+      return nullptr;
+    }
+    std::unique_ptr<TraceRing> p(new (std::nothrow) TraceRing(
+      ++tids, PyThread_get_thread_ident()));
+    if (!p)
+      return nullptr;
+    TraceRing *r = p.get();
+    rings().push_back(std::move(p));
+    return r;
+  }
+};
+
+/// Records a begin event now and the matching end event when it goes out
+/// of scope, if tracing is on when it starts.
+struct TraceScope
+{
+  const char *name;
+  const char *cat;
+  bool active;
+
+  TraceScope(const char *name, const char *cat) noexcept
+    : name(name), cat(cat), active(Tracer::on())
+  {
+    if (active)
+      Tracer::record(name, cat, 'B');
+  }
+
+  ~TraceScope() noexcept
+  {
+    if (active)
+      Tracer::record(name, cat, 'E');
+  }
+
+  TraceScope(const TraceScope &) = delete;
+  TraceScope &operator= (const TraceScope &) = delete;
+};
+
+/// Functions standing in for registered ones, to trace each call. Each
+/// `wrap` takes the next of `size` fixed trampolines and remembers which
+/// function and name it stands for; past that, functions go untraced.
+template<typename F>
+struct TracePool;
+
+template<typename R, typename...A>
+struct TracePool<R(*)(A...)>
+{
+  using F = R(*)(A...);
+  static constexpr size_t size = 256;
+
+  struct Entry { const char *name; const char *cat; F f; };
+
+  static Entry entries[size];
+
+  /// `cat` null means the category is the type of the first argument.
+  static F wrap(const char *name, const char *cat, F f)
+  {
+    static std::atomic<size_t> used{0};
+    size_t i = used++;
+    if (i >= size)
+      return f;
+    entries[i] = Entry{name, cat, f};
+    return trampolines(std::make_index_sequence<size>())[i];
+  }
+
+private:
+  template<size_t I>
+  static R call(A...a)
+  {
+    const Entry &e = entries[I];
+    TraceScope trace(e.name, e.cat ? e.cat : category(a...));
+    return e.f(a...);
+  }
+
+  template<typename...B>
+  static const char *category(PyObject *self, B...)
+  {
+    return self ? Py_TYPE(self)->tp_name : "";
+  }
+
+  template<size_t...Is>
+  static const F *trampolines(std::index_sequence<Is...>)
+  {
+    static const F fs[] = { &call<Is>... };
+    return fs;
+  }
+};
+
+template<typename R, typename...A>
+typename TracePool<R(*)(A...)>::Entry
+  TracePool<R(*)(A...)>::entries[TracePool<R(*)(A...)>::size];
+
+/// Wraps a method table entry's function so its calls are traced.
+inline PyCFunction traced_method(const char *name, int flags, PyCFunction f)
+{
+  if (flags & METH_KEYWORDS)
+    return (PyCFunction) TracePool<PyCFunctionWithKeywords>::wrap(
+      name, "call", (PyCFunctionWithKeywords) f);
+  if (flags & (METH_VARARGS | METH_O | METH_NOARGS))
+    return TracePool<PyCFunction>::wrap(name, "call", f);
+  return f;
+}
+
+inline bool trace_supported() { return true; }
+
+#else
+
+struct TraceScope
+{
+  TraceScope(const char *, const char *) noexcept { }
+};
+
+inline bool trace_supported()
+{
+  PyErr_SetString(PyExc_RuntimeError,
+                  "tracing needs a build with PYXX_TRACE defined");
+  return false;
+}
+
+#endif
+
+/// Starts recording. Module function: `trace_start()`.
+inline PyObject *trace_start(PyObject *, PyObject *)
+{
+  if (!trace_supported())
+    return nullptr;
+#ifdef PYXX_TRACE
+  Tracer::enabled().store(true);
+#endif
+  Py_RETURN_NONE;
+}
+
+/// Stops recording, keeping what was recorded. `trace_stop(clear=False)`
+/// also forgets it.
+inline PyObject *trace_stop(PyObject *, PyObject *args)
+{
+  int clear = 0;
+  if (!PyArg_ParseTuple(args, "|i", &clear) || !trace_supported())
+    return nullptr;
+#ifdef PYXX_TRACE
+  Tracer::enabled().store(false);
+  if (clear)
+    Tracer::clear();
+#endif
+  Py_RETURN_NONE;
+}
+
+/// The recorded events as a Chrome trace JSON string.
+inline PyObject *trace_dump(PyObject *, PyObject *)
+{
+  if (!trace_supported())
+    return nullptr;
+#ifdef PYXX_TRACE
+  std::string s = Tracer::dump();
+  return StringFromStringAndSize(s.data(), s.size());
+#else
+  return nullptr;
+#endif
+}
+
+}  // namespace py
+
+#endif  // PYXX_TRACE_H
@@ -5,8 +5,11 @@
 #include <Python.h>
 
 #include <tuple>
+#include <type_traits>
 #include <utility>
 
+#include "Py/Compat.h"
+
 namespace Py {
 
 template<char...cs>
@@ -32,6 +35,23 @@ using CharListConcat_t = typename CharListConcat<T...>::type;
 /// A type to signify the rest of the parameters are optional.
 struct Optional { };
 
+/// Binds `T` through an "O&" converter instead of a format code of its own.
+///
+/// Specializations define `static int convert(PyObject *, void *)`, which
+/// fills in the `T *` it is given and returns 1, or sets an exception and
+/// returns 0.
+template<typename T, typename = void>
+struct Converter { };
+
+template<typename T, typename = void>
+struct HasConverter : std::false_type { };
+
+template<typename T>
+struct HasConverter<T, decltype((void) &Converter<T>::convert)>
+  : std::true_type
+{
+};
+
 template<typename...T>
 struct PTCharListOf { };
 
@@ -71,26 +91,46 @@ template<> struct PTCharListOf<PyObject *> {
   using type = CharList<'O'>;
 };
 
+#if PYXX_PY3
+template<> struct PTCharListOf<PyUnicodeObject *> {
+  using type = CharList<'U'>;
+};
+
+template<> struct PTCharListOf<PyBytesObject *> {
+  using type = CharList<'S'>;
+};
+#else
 template<> struct PTCharListOf<PyStringObject *> {
   using type = CharList<'S'>;
 };
+#endif
 
 template<>
 struct PTCharListOf<Optional> {
   using type = CharList<'|'>;
 };
 
+template<typename T, bool = HasConverter<T>::value>
+struct FormatOf {
+  using type = typename PTCharListOf<T>::type;
+};
+
+template<typename T>
+struct FormatOf<T, true> {
+  using type = CharList<'O', '&'>;
+};
+
+template<typename T>
+using PTCharListOf_t = typename FormatOf<T>::type;
+
 template<typename...Ts>
 struct PTCharListOf<std::tuple<Ts...>> {
   using type =
     CharListConcat_t<CharList<'('>,
-                     typename PTCharListOf<std::decay_t<Ts>>::type...,
+                     PTCharListOf_t<std::decay_t<Ts>>...,
                      CharList<')'>>;
 };
 
-template<typename T>
-using PTCharListOf_t = typename PTCharListOf<T>::type;
-
 template<typename...Ts>
 struct ParseTupleBuilder { };
 
@@ -112,7 +152,7 @@ template<char...cs>
 const char ParseTupleBuilder<CharList<cs...>>::fmt[] = { cs..., '\0' };
 
 template<typename...Ts>
-constexpr const char *ParseTupleFormat(Ts...) {
+constexpr const char *ParseTupleFormat(const Ts &...) {
   return ParseTupleBuilder<CharList<>, std::decay_t<Ts>...>::fmt;
 }
 
@@ -139,9 +179,40 @@ bool ParseTuple_impl(std::tuple<Bound...> &&bound) {
   return apply_tuple(PyArg_ParseTuple, bound, Indicies());
 }
 
+/// The pointers `PyArg_ParseTuple` needs to fill in `a`.
+template<typename Arg>
+std::tuple<Arg *> bind_arg(Arg &a, std::false_type) {
+  return std::make_tuple(&a);
+}
+
+template<typename Arg>
+std::tuple<int (*)(PyObject *, void *), void *>
+bind_arg(Arg &a, std::true_type) {
+  return std::make_tuple(&Converter<Arg>::convert, (void *) &a);
+}
+
+template<typename Arg>
+decltype(auto) bind_arg(Arg &a) {
+  return bind_arg(a, HasConverter<Arg>());
+}
+
+template<typename...Ts, size_t...Is>
+decltype(auto) bind_args(std::tuple<Ts &...> &t, std::index_sequence<Is...>) {
+  return std::tuple_cat(bind_arg(std::get<Is>(t))...);
+}
+
+// Declared up front so that each overload's recursive call can find the
+// others; ADL alone would miss them for arguments outside namespace Py.
+template<typename...Bound, typename...Args>
+bool ParseTuple_impl(std::tuple<Bound...> &&bound, Optional, Args &...as);
+
+template<typename...Bound, typename...Ts, typename...Args>
+bool ParseTuple_impl(std::tuple<Bound...> &&bound, std::tuple<Ts &...> &t,
+                     Args &...as);
+
 template<typename...Bound, typename Arg, typename...Args>
 bool ParseTuple_impl(std::tuple<Bound...> &&bound, Arg &a, Args &...as) {
-  return ParseTuple_impl(std::tuple_cat(std::move(bound), std::make_tuple(&a)),
+  return ParseTuple_impl(std::tuple_cat(std::move(bound), bind_arg(a)),
                           as...);
 }
 
@@ -153,7 +224,7 @@ bool ParseTuple_impl(std::tuple<Bound...> &&bound, Optional, Args &...as) {
 template<typename...Bound, typename...Ts, typename...Args>
 bool ParseTuple_impl(std::tuple<Bound...> &&bound, std::tuple<Ts &...> &t,
                      Args &...as) {
-  auto &&mapped = map_tuple([](auto &x) { return &x; }, t);
+  auto &&mapped = bind_args(t, std::index_sequence_for<Ts...>());
   return ParseTuple_impl(std::tuple_cat(bound, std::move(mapped)),
                          as...);
 }
@@ -164,6 +235,26 @@ bool ParseTuple(PyObject *args, Args &&...as) {
                           as...);
 }
 
+/// Whether `ParseValue` can read a `T`, through a format code or its
+/// `Converter`.
+template<typename T, typename = void>
+struct IsParsable : HasConverter<T> { };
+
+template<typename T>
+struct IsParsable<T, decltype((void) typename PTCharListOf<T>::type())>
+  : std::true_type
+{
+};
+
+/// Parses a single object, rather than an argument tuple, into `x`.
+template<typename T>
+bool ParseValue(PyObject *o, T &x) {
+  auto bound = std::tuple_cat(std::make_tuple(o, ParseTupleFormat(x)),
+                              bind_arg(x));
+  constexpr size_t n = std::tuple_size<decltype(bound)>::value;
+  return apply_tuple(PyArg_Parse, bound, std::make_index_sequence<n>());
+}
+
 template<typename...Bound,
          typename Indicies = std::make_index_sequence<sizeof...(Bound)>>
 PyObject *BuildValue_impl(std::tuple<Bound...> &&bound) {
@@ -0,0 +1,272 @@
+
+#ifndef PYXX_VECTORIZE_H
+#define PYXX_VECTORIZE_H
+
+#include <Python.h>
+
+#include <initializer_list>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "Py/Object.h"
+#include "Py/Array.h"
+#include "Py/Box.h"
+#include "Py/Buffer.h"
+#include "Py/Thread.h"
+#include "Py/Tuple.h"
+
+namespace Py {
+
+/// One argument of a vectorized call: a 1-D buffer of `T`, contiguous or
+/// strided, or a scalar broadcast to every element (a stride of zero).
+///
+/// Points into itself for scalars, so it must not be moved once filled.
+template<typename T>
+struct Operand
+{
+  Operand() noexcept { buf.obj = nullptr; }
+  ~Operand() noexcept { if (buf.obj) PyBuffer_Release(&buf); }
+
+  Operand(const Operand &) = delete;
+  Operand &operator= (const Operand &) = delete;
+
+  /// Fills from `o`. Buffers must hold `T`s; anything else is parsed as a
+  /// single `T`, unless `writable` is asked for.
+  bool fill(PyObject *o, bool writable)
+  {
+    if (!PyObject_CheckBuffer(o)) {
+      if (writable) {
+        PyErr_Format(PyExc_TypeError, "out must be a writable buffer, not %s",
+                     Py_TYPE(o)->tp_name);
+        return false;
+      }
+      if (!ParseValue(o, scalar))
+        return false;
+      base = (char *) &scalar;
+      return true;
+    }
+
+    int flags = PyBUF_FORMAT | PyBUF_STRIDES;
+    if (writable)
+      flags |= PyBUF_WRITABLE;
+    if (PyObject_GetBuffer(o, &buf, flags) < 0)
+      return false;
+
+    if (buf.ndim != 1) {
+      PyErr_Format(PyExc_ValueError, "expected a 1-D buffer, got %d-D",
+                   buf.ndim);
+      return false;
+    }
+    if (!FormatMatches<T>(buf.format, buf.itemsize)) {
+      PyErr_Format(PyExc_TypeError,
+                   "buffer of '%s' where '%s' was expected",
+                   buf.format ? buf.format : "B", ItemFormat<T>::code());
+      return false;
+    }
+
+    base = (char *) buf.buf;
+    n = buf.shape[0];
+    stride = buf.strides ? buf.strides[0] : buf.itemsize;
+    return true;
+  }
+
+  bool is_scalar()     const { return n < 0; }
+  bool is_contiguous() const { return stride == sizeof(T); }
+
+  T &operator[] (Py_ssize_t i) const { return *(T *) (base + i * stride); }
+
+  T scalar = T();
+  char *base = nullptr;
+  Py_ssize_t stride = 0;
+  Py_ssize_t n = -1;
+
+private:
+  Py_buffer buf;
+};
+
+/// Turns a scalar function, `R f(A...)`, into one over buffers, in the
+/// style of a NumPy ufunc but without NumPy:
+///
+///   norms(xs, ys, zs)            # -> Array of R
+///   norms(xs, 0.0, zs, out=buf)  # scalars broadcast; writes into buf
+///
+/// Each argument is a 1-D buffer of its parameter's type (an `array.array`,
+/// `memoryview`, `Py::Array`, ...), or a scalar. Every buffer must have the
+/// same length. When nothing is strided, the loop indexes plain pointers so
+/// the compiler can vectorize it. Large inputs are split across
+/// `ThreadPool::global()` with the GIL released.
+///
+///   Py::MethodDef("norms", "...", PYXX_VECTORIZE(norm)::call),
+template<typename F, F f>
+struct Vectorize;
+
+template<typename R, typename...A, R(*f)(A...)>
+struct Vectorize<R(*)(A...), f>
+{
+  using Operands = std::tuple<Operand<std::decay_t<A>>...>;
+  using Indices  = std::index_sequence_for<A...>;
+
+  static constexpr bool all(std::initializer_list<bool> bs)
+  {
+    for (bool b : bs)
+      if (!b)
+        return false;
+    return true;
+  }
+
+  static_assert(std::is_arithmetic<R>::value &&
+                all({std::is_arithmetic<std::decay_t<A>>::value...}),
+                "vectorize() needs a function of numbers.");
+  static_assert(sizeof...(A) > 0, "vectorize() needs parameters.");
+
+  /// Below this many elements, one thread does the whole loop.
+  static constexpr size_t parallel_grain = 1 << 15;
+
+  static PyObject *call(PyObject *, PyObject *args, PyObject *kwds)
+  {
+    PyObject *out = nullptr;
+    if (kwds && PyDict_Size(kwds)) {
+      out = PyDict_GetItemString(kwds, "out");
+      if (!out || PyDict_Size(kwds) > 1) {
+        PyErr_SetString(PyExc_TypeError, "the only keyword is out");
+        return nullptr;
+      }
+    }
+
+    if (PyTuple_GET_SIZE(args) != (Py_ssize_t) sizeof...(A)) {
+      PyErr_Format(PyExc_TypeError, "expected %d arguments, got %zd",
+                   (int) sizeof...(A), PyTuple_GET_SIZE(args));
+      return nullptr;
+    }
+
+    Operands ops;
+    Py_ssize_t n = -1;
+    if (!fill(args, ops, n, Indices()))
+      return nullptr;
+
+    if (n < 0 && !out)
+      return box(apply(ops, 0, Indices()));
+
+    Operand<R> dst;
+    Object result;
+    if (out) {
+      if (!dst.fill(out, true))
+        return nullptr;
+      if (n < 0)
+        n = dst.n;
+      if (dst.n != n) {
+        PyErr_SetString(PyExc_ValueError, "out has the wrong length");
+        return nullptr;
+      }
+      result.self = out;
+      result.incref();
+    } else {
+      result.self = Array<R>::make(n);
+      if (!result.self)
+        return nullptr;
+      dst.base = (char *) ((Array<R> *) result.self)->data();
+      dst.stride = sizeof(R);
+      dst.n = n;
+    }
+
+    if ((size_t) n < parallel_grain) {
+      run(ops, dst, 0, n);
+    } else {
+      AllowThreads nogil;
+      parallel_for(n, parallel_grain, [&](size_t b, size_t e) {
+        run(ops, dst, b, e);
+      });
+    }
+    return result.release();
+  }
+
+private:
+  template<size_t...Is>
+  static bool fill(PyObject *args, Operands &ops, Py_ssize_t &n,
+                   std::index_sequence<Is...>)
+  {
+    bool ok = true;
+    (void) std::initializer_list<int>{
+      (ok = ok && std::get<Is>(ops).fill(PyTuple_GET_ITEM(args, Is), false),
+       0)...
+    };
+    if (!ok)
+      return false;
+
+    for (Py_ssize_t m : {std::get<Is>(ops).n...}) {
+      if (m < 0)
+        continue;
+      if (n >= 0 && m != n) {
+        PyErr_Format(PyExc_ValueError,
+                     "buffers differ in length (%zd and %zd)", n, m);
+        return false;
+      }
+      n = m;
+    }
+    return true;
+  }
+
+  template<size_t...Is>
+  static R apply(const Operands &ops, Py_ssize_t i, std::index_sequence<Is...>)
+  {
+    return f(std::get<Is>(ops)[i]...);
+  }
+
+  static void run(const Operands &ops, const Operand<R> &dst,
+                  size_t b, size_t e)
+  {
+    if (dst.is_contiguous() && contiguous(ops, Indices()))
+      run_contiguous(ops, (R *) dst.base, b, e, Indices());
+    else
+      for (size_t i = b; i < e; i++)
+        dst[i] = apply(ops, i, Indices());
+  }
+
+  template<size_t...Is>
+  static bool contiguous(const Operands &ops, std::index_sequence<Is...>)
+  {
+    for (bool c : {(std::get<Is>(ops).is_scalar() ||
+                    std::get<Is>(ops).is_contiguous())...})
+      if (!c)
+        return false;
+    return true;
+  }
+
+  /// A contiguous buffer as a plain pointer, or a scalar as a loop
+  /// invariant. The compiler unswitches the `scalar` test out of the loop,
+  /// leaving a shape the auto-vectorizer can handle.
+  template<typename T>
+  struct Lane
+  {
+    const T *p;
+    T v;
+    bool scalar;
+
+    T operator[] (size_t i) const { return scalar ? v : p[i]; }
+  };
+
+  template<size_t...Is>
+  static void run_contiguous(const Operands &ops, R *out, size_t b, size_t e,
+                             std::index_sequence<Is...>)
+  {
+    kernel(out, b, e,
+           Lane<std::decay_t<A>>{
+             (const std::decay_t<A> *) std::get<Is>(ops).base,
+             std::get<Is>(ops).scalar,
+             std::get<Is>(ops).is_scalar()}...);
+  }
+
+  static void kernel(R *out, size_t b, size_t e,
+                     Lane<std::decay_t<A>>...lanes)
+  {
+    for (size_t i = b; i < e; i++)
+      out[i] = f(lanes[i]...);
+  }
+};
+
+#define PYXX_VECTORIZE(f) ::Py::Vectorize<decltype(&f), &f>
+
+}  // namespace py
+
+#endif  // PYXX_VECTORIZE_H
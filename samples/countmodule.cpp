@@ -1,13 +1,16 @@
 
 #include <Python.h>
 
+#include <atomic>
+
 #include "Py/Py.h"
 
 PyObject *count(PyObject *self, PyObject *args)
 {
-  static int i = 0;
-  PySys_WriteStdout("%i\n", ++i);  // Just like printf.
-  return PyInt_FromLong(i);
+  static std::atomic<int> count{0};
+  int i = ++count;
+  PySys_WriteStdout("%i\n", i);  // Just like printf.
+  return Py::Object(i);
 }
 
 static PyMethodDef countMethods[] = {
@@ -15,7 +18,9 @@ static PyMethodDef countMethods[] = {
   {NULL, NULL, 0, NULL}
 };
 
-PyMODINIT_FUNC initcount()
+static int exec_count(PyObject *)
 {
-  Py_InitModule("count", countMethods);
+  return 0;
 }
+
+PYXX_MODULE(count, countMethods, exec_count)
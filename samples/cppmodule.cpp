@@ -5,30 +5,83 @@
 #include <vector>
 #include <string>
 #include <iostream>
+#include <sstream>
 #include <iterator>
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <cstring>
 
 #include "Py/Py.h"
 #include "Py/String.h"
 #include "Py/Tuple.h"
 #include "Py/List.h"
+#include "Py/Callable.h"
+#include "Py/Capsule.h"
+#include "Py/Async.h"
+#include "Py/Generator.h"
+#include "Py/Buffer.h"
+#include "Py/Array.h"
+#include "Py/Thread.h"
+#include "Py/Memo.h"
+
+#include "vec_api.h"
 
 static PyObject *cppError;
 
 using Ints = Py::Extention<std::vector<int>>;
 using X  = Py::Extention<int>;
 
+namespace Py {
+/// Freeing millions of ints takes long enough to hand off to a thread.
+template<> struct ReclaimPolicy<std::vector<int>> : ReclaimAbove<(16 << 20)> { };
+}
+
 struct Pi {
   Pi(int, int) {
   }
 };
 using PT = Py::Extention<Pi>;
 
+/// Reads a buffer of ints, or any iterable of them.
+static bool read_ints(PyObject *o, std::vector<int> &v)
+{
+  if (PyObject_CheckBuffer(o)) {
+    Py::View<const int> xs;
+    if (!xs.fill(o))
+      return false;
+    v.assign(xs.begin(), xs.end());
+    return true;
+  }
+
+  Py::Object seq(PySequence_Fast(o, "expected ints"), true);
+  if (!seq.self)
+    return false;
+  Py_ssize_t n = PySequence_Fast_GET_SIZE(seq.self);
+  v.resize(n);
+  for (Py_ssize_t i = 0; i < n; i++)
+    if (!Py::ParseValue(PySequence_Fast_GET_ITEM(seq.self, i), v[i]))
+      return false;
+  return true;
+}
+
+/// Ints(x, y, (z,)), or Ints(iterable) for any number of them.
 int init_ints(Ints *self, PyObject *args, PyObject *kwds)
 {
+  if (PyTuple_GET_SIZE(args) == 1) {
+    std::vector<int> v;
+    if (!read_ints(PyTuple_GET_ITEM(args, 0), v))
+      return -1;
+    Py::CriticalSection lock(self);
+    self->get().swap(v);
+    return 0;
+  }
+
   int x, y, z;
   if (!Py::ParseTuple(args, x, y, std::tie(z)))
     return -1;
 
+  Py::CriticalSection lock(self);
   self->get() = {x, y, z};
 
   return 0;
@@ -46,6 +99,363 @@ PyObject *int_str(PyObject *self)
   return Py::String("[" + s + "]");
 }
 
+/// >>> cpp.Ints(1, 2, (3,)).filter(lambda x: x % 2)
+/// [1, 3]
+PyObject *ints_filter(PyObject *self, PyObject *args)
+{
+  PyObject *f;
+  if (!Py::ParseTuple(args, f))
+    return nullptr;
+  Py::Callable<bool(int)> pred(f);
+  if (!pred.self)
+    return nullptr;
+
+  std::vector<int> xs, kept;
+  {
+    Py::CriticalSection lock(self);
+    xs = ((Ints *) self)->get();
+  }
+  for (int x : xs) {
+    bool keep;
+    if (!pred(keep, x))
+      return nullptr;
+    if (keep)
+      kept.push_back(x);
+  }
+
+  Py::List l((Py_ssize_t) 0);
+  if (!l.self || !l.extend(kept))
+    return nullptr;
+  return std::move(l);
+}
+
+/// >>> cpp.Ints(1, 2, (3,)).as_vec()
+/// <1.000000, 2.000000, 3.000000>
+/// Calls into the vec module natively, through its exported API.
+PyObject *ints_as_vec(PyObject *self, PyObject *)
+{
+  const VecApi *vec = Py::import_api<VecApi>();
+  if (!vec)
+    return nullptr;
+
+  Vec v = {0, 0, 0};
+  {
+    Py::CriticalSection lock(self);
+    const std::vector<int> &xs = ((Ints *) self)->get();
+    float *out[] = {&v.x, &v.y, &v.z};
+    for (size_t i = 0; i < xs.size() && i < 3; i++)
+      *out[i] = xs[i];
+  }
+  return vec->make(v);
+}
+
+/// >>> cpp.Ints(1, 2, (3,)).dot(vec.Vec(1, 0, 1))
+/// 4.0
+PyObject *ints_dot(PyObject *self, PyObject *args)
+{
+  PyObject *o;
+  if (!Py::ParseTuple(args, o))
+    return nullptr;
+  const VecApi *vec = Py::import_api<VecApi>();
+  if (!vec)
+    return nullptr;
+  if (!vec->vec_type->IsSubtype(o)) {
+    PyErr_Format(PyExc_TypeError, "expected vec.Vec, not %s",
+                 Py_TYPE(o)->tp_name);
+    return nullptr;
+  }
+
+  Vec v;
+  {
+    Py::CriticalSection lock(o);
+    v = ((Py::Extention<Vec> *) o)->get();
+  }
+  const float w[] = {v.x, v.y, v.z};
+  double d = 0;
+  Py::CriticalSection lock(self);
+  const std::vector<int> &xs = ((Ints *) self)->get();
+  for (size_t i = 0; i < xs.size() && i < 3; i++)
+    d += xs[i] * w[i];
+  return PyFloat_FromDouble(d);
+}
+
+/// Ints longer than this are worked on in parallel, a chunk this big each.
+static constexpr size_t ints_grain = 1 << 15;
+
+/// A copy of the items, to work on without the GIL while other threads
+/// are free to change the original.
+static std::vector<int> snapshot(PyObject *self)
+{
+  Py::CriticalSection lock(self);
+  return ((Ints *) self)->get();
+}
+
+/// >>> xs = cpp.Ints([3, 1, 2]); xs.sort(); str(xs)
+/// '[1, 2, 3]'
+/// Sorts a copy without the GIL, then swaps it in.
+PyObject *ints_sort(PyObject *self, PyObject *)
+{
+  std::vector<int> v = snapshot(self);
+  {
+    Py::AllowThreads nogil;
+    Py::parallel_sort(v.begin(), v.end(), ints_grain);
+  }
+  Py::CriticalSection lock(self);
+  ((Ints *) self)->get().swap(v);
+  Py_RETURN_NONE;
+}
+
+/// >>> list(cpp.Ints([30, 10, 20, 10]).argsort())
+/// [1, 3, 2, 0]
+/// Stable: equal items keep their order.
+PyObject *ints_argsort(PyObject *self, PyObject *)
+{
+  std::vector<int> v = snapshot(self);
+  std::vector<Py_ssize_t> order(v.size());
+  {
+    Py::AllowThreads nogil;
+    for (size_t i = 0; i < order.size(); i++)
+      order[i] = i;
+    Py::parallel_sort(order.begin(), order.end(),
+                      [&](Py_ssize_t a, Py_ssize_t b) {
+      return v[a] < v[b] || (v[a] == v[b] && a < b);
+    }, ints_grain);
+  }
+  return Py::Array<Py_ssize_t>::make(std::move(order));
+}
+
+/// >>> xs = cpp.Ints([1, 3, 3, 7])
+/// >>> xs.searchsorted(3), xs.searchsorted(3, True)
+/// (1, 3)
+/// >>> list(xs.searchsorted([0, 4, 9]))
+/// [0, 3, 4]
+/// Where each x would go to keep the (sorted) items sorted: before any
+/// equal items, or after them if `right`.
+PyObject *ints_searchsorted(PyObject *self, PyObject *args)
+{
+  PyObject *o;
+  int right = 0;
+  if (!Py::ParseTuple(args, o, Py::Optional(), right))
+    return nullptr;
+
+  auto find = [right](const std::vector<int> &v, int x) {
+    return (Py_ssize_t) ((right ? std::upper_bound(v.begin(), v.end(), x)
+                                : std::lower_bound(v.begin(), v.end(), x)) -
+                         v.begin());
+  };
+
+  if (!PyObject_CheckBuffer(o) && !PySequence_Check(o)) {
+    int x;
+    if (!Py::ParseValue(o, x))
+      return nullptr;
+    Py::CriticalSection lock(self);
+    return Py::Object(find(((Ints *) self)->get(), x)).release();
+  }
+
+  std::vector<int> qs;
+  if (!read_ints(o, qs))
+    return nullptr;
+  std::vector<int> v = snapshot(self);
+  std::vector<Py_ssize_t> out(qs.size());
+  {
+    Py::AllowThreads nogil;
+    Py::parallel_for(qs.size(), ints_grain / 16, [&](size_t b, size_t e) {
+      for (size_t i = b; i < e; i++)
+        out[i] = find(v, qs[i]);
+    });
+  }
+  return Py::Array<Py_ssize_t>::make(std::move(out));
+}
+
+/// >>> str(cpp.Ints([3, 1, 3, 2, 1]).unique())
+/// '[1, 2, 3]'
+PyObject *ints_unique(PyObject *self, PyObject *)
+{
+  std::vector<int> v = snapshot(self);
+  {
+    Py::AllowThreads nogil;
+    Py::parallel_sort(v.begin(), v.end(), ints_grain);
+    v.erase(std::unique(v.begin(), v.end()), v.end());
+  }
+  return Ints::make(std::move(v));
+}
+
+/// >>> list(cpp.Ints([1, 2, 3]).cumsum())
+/// [1, 3, 6]
+/// The running totals, as 64-bit ints, so they don't overflow.
+PyObject *ints_cumsum(PyObject *self, PyObject *)
+{
+  std::vector<int> v = snapshot(self);
+  std::vector<long long> out(v.size());
+  {
+    Py::AllowThreads nogil;
+    Py::parallel_prefix_sum(v.data(), out.data(), v.size(), ints_grain);
+  }
+  return Py::Array<long long>::make(std::move(out));
+}
+
+/// >>> str(cpp.Ints([5, 1, 9, 3]).topk(2))
+/// '[9, 5]'
+/// The k largest items, largest first.
+PyObject *ints_topk(PyObject *self, PyObject *args)
+{
+  Py_ssize_t k;
+  if (!Py::ParseTuple(args, k))
+    return nullptr;
+  if (k < 0) {
+    PyErr_SetString(PyExc_ValueError, "k must not be negative");
+    return nullptr;
+  }
+
+  std::vector<int> v = snapshot(self);
+  std::vector<int> top;
+  {
+    Py::AllowThreads nogil;
+    size_t n = std::min<size_t>(k, v.size());
+    auto keep = [n](std::vector<int> &xs) {
+      if (xs.size() > n) {
+        std::nth_element(xs.begin(), xs.begin() + n, xs.end(),
+                         std::greater<int>());
+        xs.resize(n);
+      }
+      return std::move(xs);
+    };
+    top = Py::parallel_reduce(v.size(), ints_grain, std::vector<int>(),
+      [&](size_t b, size_t e) {
+        std::vector<int> xs(v.begin() + b, v.begin() + e);
+        return keep(xs);
+      },
+      [&](const std::vector<int> &a, const std::vector<int> &b) {
+        std::vector<int> xs(a);
+        xs.insert(xs.end(), b.begin(), b.end());
+        return keep(xs);
+      });
+    std::sort(top.begin(), top.end(), std::greater<int>());
+  }
+  return Ints::make(std::move(top));
+}
+
+/// >>> list(cpp.Ints([0, 1, 2, 3, 9]).histogram(2))
+/// [4, 1]
+/// Counts the items in `bins` equal slices of [lo, hi], which default to
+/// the smallest and largest item. Items outside are left out.
+PyObject *ints_histogram(PyObject *self, PyObject *args)
+{
+  Py_ssize_t bins;
+  int lo = 0, hi = 0;
+  if (!Py::ParseTuple(args, bins, Py::Optional(), lo, hi))
+    return nullptr;
+  if (PyTuple_GET_SIZE(args) == 2) {
+    PyErr_SetString(PyExc_TypeError, "histogram() takes both lo and hi");
+    return nullptr;
+  }
+  if (bins <= 0 || hi < lo) {
+    PyErr_SetString(PyExc_ValueError, "bins must be positive and lo <= hi");
+    return nullptr;
+  }
+
+  // Allocated here, with the GIL, so too many bins is a MemoryError.
+  using Counts = std::vector<Py_ssize_t>;
+  Counts counts;
+  if ((size_t) bins > PY_SSIZE_T_MAX / sizeof(Py_ssize_t))
+    return PyErr_NoMemory();
+  try {
+    counts.resize(bins);
+  } catch (const std::bad_alloc &) {
+    return PyErr_NoMemory();
+  }
+
+  std::vector<int> v = snapshot(self);
+  if (v.empty())
+    return Py::Array<Py_ssize_t>::make(std::move(counts));
+
+  bool failed = false;
+  {
+    Py::AllowThreads nogil;
+    if (PyTuple_GET_SIZE(args) < 3) {
+      using Range = std::pair<int, int>;
+      Range r = Py::parallel_reduce(v.size(), ints_grain,
+        Range(v[0], v[0]),
+        [&](size_t b, size_t e) {
+          auto mm = std::minmax_element(v.begin() + b, v.begin() + e);
+          return Range(*mm.first, *mm.second);
+        },
+        [](const Range &a, const Range &b) {
+          return Range(std::min(a.first, b.first),
+                       std::max(a.second, b.second));
+        });
+      lo = r.first;
+      hi = r.second;
+    }
+
+    // (x - lo) * bins / width, split so it can't overflow.
+    using U = unsigned long long;
+    U width = (U) ((long long) hi - lo + 1);
+    U whole = (U) bins / width, part = (U) bins % width;
+    auto bin = [&](int x) {
+      U d = (U) ((long long) x - lo);
+      return d * whole + d * part / width;
+    };
+
+    // Each chunk counts on its own only while that costs no more than the
+    // chunk itself; more bins than that are counted in one pass.
+    if ((size_t) bins <= ints_grain) {
+      try {
+        counts = Py::parallel_reduce(v.size(), ints_grain, Counts(),
+          [&](size_t b, size_t e) {
+            Counts c(bins);
+            for (size_t i = b; i < e; i++)
+              if (v[i] >= lo && v[i] <= hi)
+                c[bin(v[i])]++;
+            return c;
+          },
+          [](const Counts &a, const Counts &b) {
+            if (a.empty())
+              return b;
+            Counts c(a);
+            for (size_t i = 0; i < b.size(); i++)
+              c[i] += b[i];
+            return c;
+          });
+      } catch (const std::bad_alloc &) {
+        failed = true;
+      }
+    } else {
+      for (int x : v)
+        if (x >= lo && x <= hi)
+          counts[bin(x)]++;
+    }
+  }
+  if (failed)
+    return PyErr_NoMemory();
+  return Py::Array<Py_ssize_t>::make(std::move(counts));
+}
+
+static PyMethodDef intsMethods[] = {
+  {"filter",  ints_filter, METH_VARARGS,
+   "filter(pred) -> the items for which pred(x) is true, as a list."},
+  {"sort",  ints_sort, METH_NOARGS,
+   "Sorts the items in place, in parallel when there are many."},
+  {"argsort",  ints_argsort, METH_NOARGS,
+   "The indices that would sort the items, stably, as an Array."},
+  {"searchsorted",  ints_searchsorted, METH_VARARGS,
+   "searchsorted(x or xs, right=False): insertion points in sorted items."},
+  {"unique",  ints_unique, METH_NOARGS,
+   "The distinct items, sorted, as a new Ints."},
+  {"cumsum",  ints_cumsum, METH_NOARGS,
+   "The running totals, as an Array of 64-bit ints."},
+  {"topk",  ints_topk, METH_VARARGS,
+   "topk(k): the k largest items, largest first, as a new Ints."},
+  {"histogram",  ints_histogram, METH_VARARGS,
+   "histogram(bins, lo=min, hi=max): counts per bin, as an Array."},
+  {"as_vec",  ints_as_vec, METH_NOARGS,
+   "The first three items as a vec.Vec."},
+  {"dot",  ints_dot, METH_VARARGS,
+   "dot(v) -> the dot product of the first three items with a vec.Vec."},
+  Py::SizeofMethod<std::vector<int>>(),
+  {NULL, NULL, 0, NULL}
+};
+
 PyObject *primes(PyObject *, PyObject *)
 {
   std::vector<int> v{1,3,5};
@@ -54,34 +464,229 @@ PyObject *primes(PyObject *, PyObject *)
   return std::move(l);
 }
 
+/// Sieve of Eratosthenes.
+std::vector<int> primes_under(int n)
+{
+  std::vector<bool> composite(n > 0 ? n : 0);
+  std::vector<int> ps;
+  for (int i = 2; i < n; i++) {
+    if (composite[i])
+      continue;
+    ps.push_back(i);
+    for (long long j = (long long) i * i; j < n; j += i)
+      composite[j] = true;
+  }
+  return ps;
+}
+
+/// The number of primes under n. Pure, so cheap to memoize.
+Py_ssize_t prime_count(int n)
+{
+  return primes_under(n).size();
+}
+
+using PrimeCount = PYXX_MEMOIZE(prime_count, 64);
+
+/// The number of ASCII vowels in `s`.
+Py_ssize_t vowels(const char *s)
+{
+  Py_ssize_t n = 0;
+  for (; *s; s++)
+    n += std::strchr("aeiouAEIOU", *s) != nullptr;
+  return n;
+}
+
+/// Keyed on the text of `s`, not on where `ParseTuple` found it.
+using Vowels = PYXX_MEMOIZE(vowels, 16);
+
+/// >>> cpp.list_primes(20)
+/// [2, 3, 5, 7, 11, 13, 17, 19]
+PyObject *list_primes(PyObject *, PyObject *args)
+{
+  int n;
+  if (!Py::ParseTuple(args, n))
+    return nullptr;
+  Py::List l((Py_ssize_t) 0);
+  if (!l.self || !l.extend(primes_under(n)))
+    return nullptr;
+  return std::move(l);
+}
+
+/// >>> cpp.words("to be or not")
+/// ['to', 'be', 'or', 'not']
+PyObject *words(PyObject *, PyObject *args)
+{
+  const char *s;
+  if (!Py::ParseTuple(args, s))
+    return nullptr;
+
+  std::istringstream in(s);
+  Py::List l((Py_ssize_t) 0);
+  if (!l.self)
+    return nullptr;
+  auto it = std::copy(std::istream_iterator<std::string>(in),
+                      std::istream_iterator<std::string>(),
+                      Py::back_inserter(l));
+  if (!it.ok())
+    return nullptr;
+  return std::move(l);
+}
+
+/// >>> t = cpp.async_primes(10**8)
+/// >>> ...  # Python keeps running meanwhile.
+/// >>> t.result()[:4]
+/// [2, 3, 5, 7]
+PyObject *async_primes(PyObject *, PyObject *args)
+{
+  int n;
+  if (!Py::ParseTuple(args, n))
+    return nullptr;
+  return Py::async_call([n] { return primes_under(n); });
+}
+
+/// >>> it = cpp.iter_primes()
+/// >>> next(it), next(it), next(it)
+/// (2, 3, 5)
+/// Unbounded, unless given a limit. Primes are found 256 at a time without
+/// the GIL, and only boxed as they are consumed.
+PyObject *iter_primes(PyObject *, PyObject *args)
+{
+  long long limit = -1;
+  int n = -1;
+  if (!Py::ParseTuple(args, Py::Optional(), n))
+    return nullptr;
+  if (n >= 0)
+    limit = n;
+
+  std::vector<long long> found;
+  long long next = 2;
+  return Py::Generator::from_function<long long>(
+    [=](long long &p) mutable {
+      for (;; next++) {
+        if (limit >= 0 && next >= limit)
+          return false;
+        bool prime = true;
+        for (long long q : found) {
+          if (q * q > next)
+            break;
+          if (next % q == 0) {
+            prime = false;
+            break;
+          }
+        }
+        if (prime) {
+          found.push_back(next);
+          p = next++;
+          return true;
+        }
+      }
+    }, 256);
+}
+
+/// Counts newlines in any bytes-like object (or str) without copying it.
+PyObject *count_lines(PyObject *, PyObject *args)
+{
+  Py::View<const char> data;
+  if (!Py::ParseTuple(args, data))
+    return nullptr;
+  return Py::Object((Py_ssize_t) std::count(data.begin(), data.end(), '\n'))
+    .release();
+}
+
+/// >>> cpp.sorted([3.5, -1.0, 2.25])
+/// [-1.0, 2.25, 3.5]
+/// Like the builtin, but sorts lists of ints, floats or strs unboxed.
+PyObject *sorted(PyObject *, PyObject *args)
+{
+  PyObject *xs, *key = nullptr;
+  if (!Py::ParseTuple(args, xs, Py::Optional(), key))
+    return nullptr;
+
+  Py::List l(PySequence_List(xs), true);
+  if (!l.self)
+    return nullptr;
+  if (key == Py_None)
+    key = nullptr;
+  if (!(key ? l.SortUnboxed(key) : l.SortUnboxed()))
+    return nullptr;
+  return l.release();
+}
+
 static PyMethodDef cppMethods[] = {
   {"primes",  primes, METH_VARARGS,
    "prime numbers under ten: "},
+  {"async_primes",  async_primes, METH_VARARGS,
+   "Finds the primes under n on a worker thread. Returns a Task."},
+  {"list_primes",  list_primes, METH_VARARGS,
+   "list_primes(n) -> the primes under n, as a list."},
+  {"words",  words, METH_VARARGS,
+   "words(s) -> the whitespace-separated words of s, as a list."},
+  {"iter_primes",  iter_primes, METH_VARARGS,
+   "iter_primes([n]) -> an iterator over the primes (under n)."},
+  {"count_lines",  count_lines, METH_VARARGS,
+   "Counts the newlines in a str or bytes-like object."},
+  {"sorted",  sorted, METH_VARARGS,
+   "sorted(iterable, key=None) as a new list, by position only."},
+  Py::MethodDef("trace_start", "Starts tracing native calls.",
+                Py::trace_start),
+  Py::MethodDef("trace_stop", "trace_stop(clear=False): stops tracing.",
+                Py::trace_stop),
+  Py::MethodDef("trace_dump", "The trace so far, as Chrome trace JSON.",
+                Py::trace_dump),
+  Py::MethodDef("type_stats",
+                "{type: (live, created, bytes)} for every C++ type.",
+                Py::type_stats),
+  Py::MethodDef("reclaim_wait",
+                "Waits for values being destroyed in the background.",
+                Py::reclaim_wait),
+  Py::MethodDef("prime_count", "The number of primes under n (memoized).",
+                PrimeCount::call),
+  Py::MethodDef("prime_count_cache_info",
+                "(hits, misses, maxsize, currsize) of prime_count's cache.",
+                PrimeCount::info),
+  Py::MethodDef("prime_count_cache_clear",
+                "Clears prime_count's cache, or just the entry for (n,).",
+                PrimeCount::clear),
+  Py::MethodDef("vowels", "The number of vowels in s (memoized).",
+                Vowels::call),
+  Py::MethodDef("vowels_cache_info",
+                "(hits, misses, maxsize, currsize) of vowels' cache.",
+                Vowels::info),
   {NULL, NULL, 0, NULL}
 };
 
-PyMODINIT_FUNC initcpp(void)
+static int exec_cpp(PyObject *m)
 {
   Ints::type.tp_name = "cpp.Ints";
   Ints::type.tp_init = (initproc)init_ints;
   Ints::type.tp_str = int_str;
+  Ints::type.tp_methods = intsMethods;
 
   X::type.tp_name = "cpp.X";
   if (PyType_Ready(&Ints::type) < 0)
-    return;
+    return -1;
   if (PyType_Ready(&X::type) < 0)
-    return;
-
-  PyObject *m = Py_InitModule("cpp", cppMethods);
-  if (m == NULL)
-    return;
+    return -1;
+  if (Py::Task::Ready("cpp.Task") < 0)
+    return -1;
+  if (Py::Generator::Ready("cpp.Generator") < 0)
+    return -1;
+  if (Py::Array<Py_ssize_t>::Ready() < 0)
+    return -1;
+  if (Py::Array<long long>::Ready() < 0)
+    return -1;
 
   Py_INCREF(&Ints::type);
   PyModule_AddObject(m, "Ints", (PyObject *) &Ints::type);
   Py_INCREF(&X::type);
   PyModule_AddObject(m, "X", (PyObject *) &X::type);
+  Py_INCREF(&Py::Task::type);
+  PyModule_AddObject(m, "Task", (PyObject *) &Py::Task::type);
 
   cppError = PyErr_NewException((char *)"cpp.error", NULL, NULL);
   Py_INCREF(cppError);
   PyModule_AddObject(m, "error", cppError);
+  return 0;
 }
+
+PYXX_MODULE(cpp, cppMethods, exec_cpp)
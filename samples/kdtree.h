@@ -0,0 +1,204 @@
+
+#ifndef VEC_KDTREE_H
+#define VEC_KDTREE_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "Py/Thread.h"
+
+/// A static 3-D k-d tree, stored implicitly: the points are reordered so
+/// that each range's median, on axis `depth % 3`, sits in its middle, with
+/// the lower half before it and the upper half after. No Python in here.
+struct KDTree
+{
+  using Point = std::array<float, 3>;
+
+  /// Builds over `ps`. The top levels split in parallel on
+  /// `Py::ThreadPool::global()`.
+  void build(std::vector<Point> ps)
+  {
+    pts = std::move(ps);
+    std::vector<size_t> order(pts.size());
+    std::iota(order.begin(), order.end(), size_t(0));
+    split(order, 0, order.size(), 0);
+
+    std::vector<Point> sorted(pts.size());
+    for (size_t i = 0; i < order.size(); i++)
+      sorted[i] = pts[order[i]];
+    pts.swap(sorted);
+    ids.swap(order);
+  }
+
+  size_t size() const { return pts.size(); }
+
+  size_t heap_size() const
+  {
+    return pts.capacity() * sizeof(Point) + ids.capacity() * sizeof(size_t);
+  }
+
+  /// The indices of the `k` points nearest `q`, nearest first, padded with
+  /// -1 if there are fewer than `k`.
+  void nearest(const Point &q, size_t k, Py_ssize_t *out) const
+  {
+    std::vector<std::pair<float, size_t>> heap;
+    size_t m = std::min(k, pts.size());  // Past that is padding.
+    heap.reserve(m + 1);
+    if (m)
+      nearest(q, m, heap, 0, pts.size(), 0);
+    std::sort_heap(heap.begin(), heap.end());
+    for (size_t i = 0; i < k; i++)
+      out[i] = i < heap.size() ? (Py_ssize_t) ids[heap[i].second] : -1;
+  }
+
+  /// Appends the indices of the points within `r` of `q`, ascending. `r`
+  /// must not be negative.
+  void within(const Point &q, float r, std::vector<Py_ssize_t> &out) const
+  {
+    size_t n = out.size();
+    within(q, r * r, out, 0, pts.size(), 0);
+    std::sort(out.begin() + n, out.end());
+  }
+
+  /// Appends the indices of the points in the box [lo, hi], ascending.
+  void in_box(const Point &lo, const Point &hi,
+              std::vector<Py_ssize_t> &out) const
+  {
+    size_t n = out.size();
+    in_box(lo, hi, out, 0, pts.size(), 0);
+    std::sort(out.begin() + n, out.end());
+  }
+
+private:
+  std::vector<Point> pts;   // In tree order.
+  std::vector<size_t> ids;  // The caller's index of each of `pts`.
+
+  /// Ranges this small are scanned rather than split.
+  static constexpr size_t leaf = 8;
+  /// Ranges this big build their halves in parallel.
+  static constexpr size_t parallel_min = 1 << 16;
+
+  static float dist2(const Point &a, const Point &b)
+  {
+    float dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+    return dx*dx + dy*dy + dz*dz;
+  }
+
+  void split(std::vector<size_t> &order, size_t b, size_t e, int depth)
+  {
+    if (e - b <= leaf)
+      return;
+
+    size_t mid = b + (e - b) / 2;
+    int axis = depth % 3;
+    std::nth_element(order.begin() + b, order.begin() + mid,
+                     order.begin() + e, [&](size_t i, size_t j) {
+      return pts[i][axis] < pts[j][axis];
+    });
+
+    if (e - b < parallel_min) {
+      split(order, b, mid, depth + 1);
+      split(order, mid + 1, e, depth + 1);
+      return;
+    }
+    Py::parallel_for(2, 1, [&](size_t i, size_t j) {
+      for (; i < j; i++) {
+        if (i == 0)
+          split(order, b, mid, depth + 1);
+        else
+          split(order, mid + 1, e, depth + 1);
+      }
+    });
+  }
+
+  void nearest(const Point &q, size_t k,
+               std::vector<std::pair<float, size_t>> &heap,
+               size_t b, size_t e, int depth) const
+  {
+    auto consider = [&](size_t i) {
+      float d = dist2(q, pts[i]);
+      if (heap.size() < k || d < heap.front().first) {
+        heap.emplace_back(d, i);
+        std::push_heap(heap.begin(), heap.end());
+        if (heap.size() > k) {
+          std::pop_heap(heap.begin(), heap.end());
+          heap.pop_back();
+        }
+      }
+    };
+
+    if (e - b <= leaf) {
+      for (size_t i = b; i < e; i++)
+        consider(i);
+      return;
+    }
+
+    size_t mid = b + (e - b) / 2;
+    int axis = depth % 3;
+    float diff = q[axis] - pts[mid][axis];
+    consider(mid);
+    if (diff < 0) {
+      nearest(q, k, heap, b, mid, depth + 1);
+      if (heap.size() < k || diff * diff < heap.front().first)
+        nearest(q, k, heap, mid + 1, e, depth + 1);
+    } else {
+      nearest(q, k, heap, mid + 1, e, depth + 1);
+      if (heap.size() < k || diff * diff < heap.front().first)
+        nearest(q, k, heap, b, mid, depth + 1);
+    }
+  }
+
+  void within(const Point &q, float r2, std::vector<Py_ssize_t> &out,
+              size_t b, size_t e, int depth) const
+  {
+    if (e - b <= leaf) {
+      for (size_t i = b; i < e; i++)
+        if (dist2(q, pts[i]) <= r2)
+          out.push_back(ids[i]);
+      return;
+    }
+
+    size_t mid = b + (e - b) / 2;
+    int axis = depth % 3;
+    float diff = q[axis] - pts[mid][axis];
+    if (dist2(q, pts[mid]) <= r2)
+      out.push_back(ids[mid]);
+    if (diff <= 0 || diff * diff <= r2)
+      within(q, r2, out, b, mid, depth + 1);
+    if (diff >= 0 || diff * diff <= r2)
+      within(q, r2, out, mid + 1, e, depth + 1);
+  }
+
+  void in_box(const Point &lo, const Point &hi, std::vector<Py_ssize_t> &out,
+              size_t b, size_t e, int depth) const
+  {
+    auto inside = [&](const Point &p) {
+      return lo[0] <= p[0] && p[0] <= hi[0] &&
+             lo[1] <= p[1] && p[1] <= hi[1] &&
+             lo[2] <= p[2] && p[2] <= hi[2];
+    };
+
+    if (e - b <= leaf) {
+      for (size_t i = b; i < e; i++)
+        if (inside(pts[i]))
+          out.push_back(ids[i]);
+      return;
+    }
+
+    size_t mid = b + (e - b) / 2;
+    int axis = depth % 3;
+    float s = pts[mid][axis];
+    if (inside(pts[mid]))
+      out.push_back(ids[mid]);
+    if (lo[axis] <= s)
+      in_box(lo, hi, out, b, mid, depth + 1);
+    if (hi[axis] >= s)
+      in_box(lo, hi, out, mid + 1, e, depth + 1);
+  }
+};
+
+#endif  // VEC_KDTREE_H
@@ -1,4 +1,7 @@
-from distutils.core import setup, Extension
+try:
+    from setuptools import setup, Extension
+except ImportError:
+    from distutils.core import setup, Extension
 
 cxxflags = ['--std=c++14', '-I../include']
 
@@ -12,7 +15,10 @@ cpp = Extension('cpp',
 vec = Extension('vec',
                 sources = ['vecmodule.cpp'],
                 extra_compile_args = cxxflags)
+traced = Extension('traced',
+                   sources = ['tracedmodule.cpp'],
+                   extra_compile_args = cxxflags)
 
 setup (name = 'cpp',
        version = '1.0',
-       ext_modules = [cnt, cpp, vec])
+       ext_modules = [cnt, cpp, vec, traced])
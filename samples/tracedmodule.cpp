@@ -0,0 +1,46 @@
+// A module built with tracing compiled in, whatever the build flags say.
+#ifndef PYXX_TRACE
+# define PYXX_TRACE
+#endif
+
+#include <Python.h>
+
+#include <chrono>
+#include <thread>
+
+#include "Py/Py.h"
+#include "Py/Thread.h"
+#include "Py/Trace.h"
+
+/// >>> traced.work(100)
+/// Sleeps `us` microseconds with the GIL released, so calls from several
+/// threads overlap on the timeline.
+PyObject *work(PyObject *, PyObject *args)
+{
+  int us;
+  if (!PyArg_ParseTuple(args, "i", &us))
+    return nullptr;
+  {
+    Py::AllowThreads nogil;
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+  }
+  Py_RETURN_NONE;
+}
+
+static PyMethodDef tracedMethods[] = {
+  Py::MethodDef("work", "work(us): sleeps without the GIL.", work),
+  Py::MethodDef("trace_start", "Starts tracing native calls.",
+                Py::trace_start),
+  Py::MethodDef("trace_stop", "trace_stop(clear=False): stops tracing.",
+                Py::trace_stop),
+  Py::MethodDef("trace_dump", "The trace so far, as Chrome trace JSON.",
+                Py::trace_dump),
+  {NULL, NULL, 0, NULL}
+};
+
+static int exec_traced(PyObject *)
+{
+  return 0;
+}
+
+PYXX_MODULE(traced, tracedMethods, exec_traced)
@@ -0,0 +1,29 @@
+
+#ifndef VEC_API_H
+#define VEC_API_H
+
+#include <Python.h>
+
+#include "Py/Extention.h"
+
+struct Vec {
+  float x, y, z;
+};
+
+/// The native API the `vec` module exports, for other extensions to use
+/// without going through Python. Get it with `Py::import_api<VecApi>()`.
+struct VecApi
+{
+  static constexpr const char *capsule = "vec._C_API";
+  static constexpr unsigned version = 1;
+
+  /// vec.Vec. Its objects are laid out as `Py::Extention<Vec>`.
+  Py::Type *vec_type;
+  /// A new vec.Vec holding `v`.
+  PyObject *(*make)(const Vec &v);
+
+  Vec (*cross)(const Vec &a, const Vec &b);
+  float (*norm)(float x, float y, float z);
+};
+
+#endif  // VEC_API_H
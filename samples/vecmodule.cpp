@@ -1,9 +1,27 @@
 
 #include <Python.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <tuple>
+#include <vector>
+
 #include "Py/Py.h"
 #include "Py/Tuple.h"
 #include "Py/String.h"
+#include "Py/Lazy.h"
+#include "Py/Fields.h"
+#include "Py/Function.h"
+#include "Py/Map.h"
+#include "Py/Vectorize.h"
+#include "Py/Capsule.h"
+#include "Py/Load.h"
+
+#include "kdtree.h"
+#include "vec_api.h"
 
 /// This module is roughly equivalent to the following Python code:
 ///
@@ -43,10 +61,6 @@
 ///   def __xor__(self, other):
 ///     ...
 
-struct Vec {
-  float x, y, z;
-};
-
 constexpr Vec operator- (const Vec &v) {
   return {-v.x, -v.y, -v.z};
 }
@@ -92,6 +106,7 @@ constexpr Vec operator^ (const Vec &a, const Vec &b) {
 }
 
 using PyVec = Py::NumExtention<Vec>;
+using LazyVec = Py::Lazy<Vec>;
 
 int init_vec(PyVec *self, PyObject *args, PyObject *)
 {
@@ -109,48 +124,710 @@ PyObject *vec_str(PyVec *self)
                     ">");
 }
 
-PyObject *cross(PyObject *self, PyObject *args)
+/// Four floats on a 32-byte boundary, the way SIMD code wants them. Its
+/// `Extention` is over-aligned, so objects come from `Py::aligned_alloc`.
+struct alignas(32) Vec4
+{
+  float x, y, z, w;
+};
+
+constexpr Vec4 operator+ (const Vec4 &a, const Vec4 &b) {
+  return {a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w};
+}
+
+constexpr Vec4 operator- (const Vec4 &a, const Vec4 &b) {
+  return {a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w};
+}
+
+using PyVec4 = Py::NumExtention<Vec4>;
+
+int init_vec4(PyVec4 *self, PyObject *args, PyObject *)
+{
+  Vec4 &v = self->get();
+  if (!Py::ParseTuple(args, v.x, v.y, v.z, v.w))
+    return -1;
+  return 0;
+}
+
+/// >>> vec.Vec4(1, 2, 3, 4).aligned()  # True unless the allocator slipped
+/// Whether the components start on their 32-byte boundary.
+PyObject *vec4_aligned(PyObject *self, PyObject *)
+{
+  uintptr_t p = (uintptr_t) ((PyVec4 *) self)->ptr();
+  return Py::Object(p % alignof(Vec4) == 0).release();
+}
+
+static PyMethodDef vec4Methods[] = {
+  {"aligned", vec4_aligned, METH_NOARGS,
+   "Whether the components are 32-byte aligned."},
+  Py::SizeofMethod<Vec4>(),
+  {NULL, NULL, 0, NULL}
+};
+
+namespace Py {
+template<> struct Converter<Vec> : ExtentionConverter<Vec> { };
+
+/// A Vec is a row of three floats, so an `Array<Vec>` exports as (n, 3).
+template<> struct ItemFormat<Vec> {
+  using component = float;
+  static constexpr Py_ssize_t width = 3;
+  static const char *code() { return "f"; }
+};
+}
+
+/// Same as `a ^ b`, but callable in bulk through `cross_map`.
+Vec cross(const Vec &a, const Vec &b)
+{
+  return a ^ b;
+}
+
+/// The length of (x, y, z), callable over whole buffers through `norms`.
+float norm(float x, float y, float z)
+{
+  return std::sqrt(x*x + y*y + z*z);
+}
+
+/// >>> (vec.lazy(a) + b - c ^ d).eval()
+/// Builds the whole expression before computing anything.
+PyObject *lazy(PyObject *, PyObject *args)
+{
+  PyObject *o;
+  if (!Py::ParseTuple(args, o))
+    return nullptr;
+  return LazyVec::wrap(o);
+}
+
+using PyKDTree = Py::Extention<KDTree>;
+
+static_assert(sizeof(KDTree::Point) == 3 * sizeof(float),
+              "Points must pack like a float buffer.");
+
+/// Points given as a flat buffer of floats, three per point, which is
+/// borrowed, or as an iterable of Vecs, which is copied.
+struct Points
+{
+  Py::View<const float> view;
+  std::vector<KDTree::Point> copy;
+  const float *data = nullptr;
+  size_t n = 0;
+
+  bool fill(PyObject *o)
+  {
+    if (PyObject_CheckBuffer(o)) {
+      if (!view.fill(o))
+        return false;
+      if (view.size() % 3) {
+        PyErr_SetString(PyExc_ValueError, "expected three floats per point");
+        return false;
+      }
+      data = view.data();
+      n = view.size() / 3;
+      return true;
+    }
+
+    Py::Object seq(PySequence_Fast(o, "expected a float buffer or Vecs"),
+                   true);
+    if (!seq.self)
+      return false;
+    n = PySequence_Fast_GET_SIZE(seq.self);
+    copy.resize(n);
+    for (size_t i = 0; i < n; i++) {
+      PyObject *item = PySequence_Fast_GET_ITEM(seq.self, i);
+      if (!PyVec::type.IsSubtype(item)) {
+        PyErr_Format(PyExc_TypeError, "expected a Vec, not %s",
+                     Py_TYPE(item)->tp_name);
+        return false;
+      }
+      const Vec &v = ((PyVec *) item)->get();
+      copy[i] = {{v.x, v.y, v.z}};
+    }
+    data = (const float *) copy.data();
+    return true;
+  }
+
+  const float *operator[] (size_t i) const { return data + 3 * i; }
+};
+
+static bool read_points(PyObject *o, std::vector<KDTree::Point> &ps)
+{
+  Points p;
+  if (!p.fill(o))
+    return false;
+  if (p.view.data())
+    ps.assign((const KDTree::Point *) p.data,
+              (const KDTree::Point *) p.data + p.n);
+  else
+    ps = std::move(p.copy);
+  return true;
+}
+
+static KDTree::Point point_of(const Vec &v)
+{
+  return {{v.x, v.y, v.z}};
+}
+
+/// >>> t = vec.KDTree(points)  # float buffer of 3n, or Vecs
+/// The tree is built before the object exists and has no `__init__` to
+/// rebuild it, so queries read it from any thread without locking.
+PyObject *new_kdtree(PyTypeObject *type, PyObject *args, PyObject *)
+{
+  PyObject *o;
+  std::vector<KDTree::Point> ps;
+  if (!Py::ParseTuple(args, o) || !read_points(o, ps))
+    return nullptr;
+
+  KDTree tree;
+  {
+    Py::AllowThreads nogil;
+    tree.build(std::move(ps));
+  }
+
+  PyObject *self = Py::default_new<KDTree>()(type, nullptr, nullptr);
+  if (self) {
+    Py::CriticalSection lock(self);  // For `type_stats`.
+    ((PyKDTree *) self)->get() = std::move(tree);
+  }
+  return self;
+}
+
+Py_ssize_t kdtree_len(PyObject *self)
+{
+  return ((PyKDTree *) self)->get().size();
+}
+
+/// >>> t.nearest(Vec(0, 0, 0), 3)   # the three nearest, nearest first
+/// >>> t.nearest(queries, 3)        # 3 per query, for a float buffer
+PyObject *kdtree_nearest(PyObject *self, PyObject *args)
+{
+  PyObject *o;
+  Py_ssize_t k = 1;
+  if (!Py::ParseTuple(args, o, Py::Optional(), k))
+    return nullptr;
+  if (k < 0) {
+    PyErr_SetString(PyExc_ValueError, "k must not be negative");
+    return nullptr;
+  }
+
+  std::vector<KDTree::Point> qs;
+  if (PyVec::type.IsSubtype(o))
+    qs.push_back(point_of(((PyVec *) o)->get()));
+  else if (!read_points(o, qs))
+    return nullptr;
+
+  // Sized here, with the GIL, so running out of memory is a MemoryError.
+  if (!qs.empty() &&
+      (size_t) k > PY_SSIZE_T_MAX / sizeof(Py_ssize_t) / qs.size())
+    return PyErr_NoMemory();
+  const KDTree &tree = ((PyKDTree *) self)->get();
+  std::vector<Py_ssize_t> out;
+  bool failed = false;
+  try {
+    out.resize(qs.size() * k);
+  } catch (const std::bad_alloc &) {
+    return PyErr_NoMemory();
+  }
+  {
+    Py::AllowThreads nogil;
+    try {
+      Py::parallel_for(qs.size(), 64, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; i++)
+          tree.nearest(qs[i], k, &out[i * k]);
+      });
+    } catch (const std::bad_alloc &) {
+      failed = true;
+    }
+  }
+  if (failed)
+    return PyErr_NoMemory();
+  return Py::Array<Py_ssize_t>::make(std::move(out));
+}
+
+/// >>> t.within(Vec(0, 0, 0), 1.5)  # indices within 1.5, ascending
+/// >>> idx, offsets = t.within(queries, 1.5)
+/// For a buffer of queries, query i's hits are idx[offsets[i]:offsets[i+1]].
+PyObject *kdtree_within(PyObject *self, PyObject *args)
+{
+  PyObject *o;
+  float r;
+  if (!Py::ParseTuple(args, o, r))
+    return nullptr;
+  if (!(r >= 0)) {
+    PyErr_SetString(PyExc_ValueError, "r must be a number >= 0");
+    return nullptr;
+  }
+
+  const KDTree &tree = ((PyKDTree *) self)->get();
+  if (PyVec::type.IsSubtype(o)) {
+    std::vector<Py_ssize_t> out;
+    try {
+      tree.within(point_of(((PyVec *) o)->get()), r, out);
+    } catch (const std::bad_alloc &) {
+      return PyErr_NoMemory();
+    }
+    return Py::Array<Py_ssize_t>::make(std::move(out));
+  }
+
+  std::vector<KDTree::Point> qs;
+  if (!read_points(o, qs))
+    return nullptr;
+
+  std::vector<std::vector<Py_ssize_t>> hits(qs.size());
+  std::vector<Py_ssize_t> out, offsets(qs.size() + 1);
+  bool failed = false;
+  {
+    Py::AllowThreads nogil;
+    try {
+      Py::parallel_for(qs.size(), 64, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; i++)
+          tree.within(qs[i], r, hits[i]);
+      });
+      for (size_t i = 0; i < hits.size(); i++)
+        offsets[i + 1] = offsets[i] + hits[i].size();
+      out.reserve(offsets.back());
+      for (const auto &h : hits)
+        out.insert(out.end(), h.begin(), h.end());
+    } catch (const std::bad_alloc &) {
+      failed = true;
+    }
+  }
+  if (failed)
+    return PyErr_NoMemory();
+
+  Py::Object idx(Py::Array<Py_ssize_t>::make(std::move(out)), true);
+  Py::Object offs(Py::Array<Py_ssize_t>::make(std::move(offsets)), true);
+  if (!idx.self || !offs.self)
+    return nullptr;
+  return PyTuple_Pack(2, idx.self, offs.self);
+}
+
+/// >>> t.in_box(Vec(0, 0, 0), Vec(1, 1, 1))  # indices inside, ascending
+PyObject *kdtree_in_box(PyObject *self, PyObject *args)
+{
+  Vec lo, hi;
+  if (!Py::ParseTuple(args, lo, hi))
+    return nullptr;
+
+  std::vector<Py_ssize_t> out;
+  ((PyKDTree *) self)->get().in_box(point_of(lo), point_of(hi), out);
+  return Py::Array<Py_ssize_t>::make(std::move(out));
+}
+
+static PyMethodDef kdtreeMethods[] = {
+  Py::MethodDef("nearest", "nearest(q, k=1): indices of the k nearest.",
+                kdtree_nearest),
+  Py::MethodDef("within", "within(q, r): indices within r of q.",
+                kdtree_within),
+  Py::MethodDef("in_box", "in_box(lo, hi): indices inside the box.",
+                kdtree_in_box),
+  Py::SizeofMethod<KDTree>(),
+  {NULL, NULL, 0, NULL}
+};
+
+/// Points per chunk of a reduction. Fixed, so results don't depend on the
+/// number of threads.
+constexpr size_t reduce_grain = 1 << 14;
+
+struct Sum3
+{
+  double x, y, z;
+
+  Sum3 operator+ (const Sum3 &o) const { return {x + o.x, y + o.y, z + o.z}; }
+};
+
+/// Sums a chunk in float, twelve independent lanes at a time, which the
+/// compiler can keep in vector registers.
+static Sum3 sum_fast(const Points &ps, size_t b, size_t e)
+{
+  float acc[12] = { };
+  size_t i = b;
+  for (; i + 4 <= e; i += 4) {
+    const float *p = ps[i];
+    for (int j = 0; j < 12; j++)
+      acc[j] += p[j];
+  }
+  for (; i < e; i++)
+    for (int j = 0; j < 3; j++)
+      acc[j] += ps[i][j];
+
+  Sum3 s = { };
+  for (int j = 0; j < 12; j += 3) {
+    s.x += acc[j];
+    s.y += acc[j + 1];
+    s.z += acc[j + 2];
+  }
+  return s;
+}
+
+/// Sums a chunk in double with Kahan compensation.
+static Sum3 sum_precise(const Points &ps, size_t b, size_t e)
+{
+  double s[3] = { }, c[3] = { };
+  for (size_t i = b; i < e; i++) {
+    for (int j = 0; j < 3; j++) {
+      double y = ps[i][j] - c[j];
+      double t = s[j] + y;
+      c[j] = (t - s[j]) - y;
+      s[j] = t;
+    }
+  }
+  return {s[0], s[1], s[2]};
+}
+
+static Sum3 sum_points(const Points &ps, bool precise)
+{
+  Py::AllowThreads nogil;
+  return Py::parallel_reduce(ps.n, reduce_grain, Sum3{0, 0, 0},
+                             [&](size_t b, size_t e) {
+    return precise ? sum_precise(ps, b, e) : sum_fast(ps, b, e);
+  }, std::plus<Sum3>());
+}
+
+/// >>> vec.sum(points)          # float lanes, summed pairwise
+/// >>> vec.sum(points, True)    # Kahan-compensated, in double
+/// Either way the result is the same on every run and machine.
+PyObject *sum(PyObject *, PyObject *args)
+{
+  PyObject *o;
+  int precise = 0;
+  Points ps;
+  if (!Py::ParseTuple(args, o, Py::Optional(), precise) || !ps.fill(o))
+    return nullptr;
+
+  Sum3 s = sum_points(ps, precise);
+  return PyVec::make(Vec{(float) s.x, (float) s.y, (float) s.z});
+}
+
+/// >>> vec.centroid(points)
+PyObject *centroid(PyObject *, PyObject *args)
+{
+  PyObject *o;
+  Points ps;
+  if (!Py::ParseTuple(args, o) || !ps.fill(o))
+    return nullptr;
+  if (!ps.n) {
+    PyErr_SetString(PyExc_ValueError, "centroid of no points");
+    return nullptr;
+  }
+
+  Sum3 s = sum_points(ps, true);
+  return PyVec::make(Vec{(float) (s.x / ps.n), (float) (s.y / ps.n),
+                         (float) (s.z / ps.n)});
+}
+
+/// >>> lo, hi = vec.bounds(points)
+PyObject *bounds(PyObject *, PyObject *args)
 {
-  PyObject *o1, *o2;
-  if (!Py::ParseTuple(args, o1, o2))
+  PyObject *o;
+  Points ps;
+  if (!Py::ParseTuple(args, o) || !ps.fill(o))
+    return nullptr;
+  if (!ps.n) {
+    PyErr_SetString(PyExc_ValueError, "bounds of no points");
     return nullptr;
+  }
+
+  struct Box { Vec lo, hi; };
+  Box box;
+  {
+    Py::AllowThreads nogil;
+    const float *p0 = ps[0];
+    Box first = {{p0[0], p0[1], p0[2]}, {p0[0], p0[1], p0[2]}};
+    box = Py::parallel_reduce(ps.n, reduce_grain, first,
+                              [&](size_t b, size_t e) {
+      Box r = first;
+      for (size_t i = b; i < e; i++) {
+        const float *p = ps[i];
+        r.lo = {std::min(r.lo.x, p[0]), std::min(r.lo.y, p[1]),
+                std::min(r.lo.z, p[2])};
+        r.hi = {std::max(r.hi.x, p[0]), std::max(r.hi.y, p[1]),
+                std::max(r.hi.z, p[2])};
+      }
+      return r;
+    }, [](const Box &a, const Box &b) {
+      return Box{{std::min(a.lo.x, b.lo.x), std::min(a.lo.y, b.lo.y),
+                  std::min(a.lo.z, b.lo.z)},
+                 {std::max(a.hi.x, b.hi.x), std::max(a.hi.y, b.hi.y),
+                  std::max(a.hi.z, b.hi.z)}};
+    });
+  }
 
-  // Ensure o1 and 2 are the right types.
-  if (!PyVec::type.IsSubtype(o1) || !PyVec::type.IsSubtype(o2))
+  Py::Object lo(PyVec::make(box.lo), true), hi(PyVec::make(box.hi), true);
+  if (!lo.self || !hi.self)
     return nullptr;
-  
-  Vec &v = ((PyVec *) o1)->get(), &w = ((PyVec *) o2)->get();
-  float i = v.y*w.z - v.z*w.y;
-  float j = v.z*w.x - v.x*w.z;
-  float k = v.x*w.y - v.y*w.x;
+  return PyTuple_Pack(2, lo.self, hi.self);
+}
+
+/// >>> vec.lengths(points)  # Array of float, |p| for each p
+PyObject *lengths(PyObject *, PyObject *args)
+{
+  PyObject *o;
+  Points ps;
+  if (!Py::ParseTuple(args, o) || !ps.fill(o))
+    return nullptr;
+
+  std::vector<float> out(ps.n);
+  {
+    Py::AllowThreads nogil;
+    Py::parallel_for(ps.n, reduce_grain, [&](size_t b, size_t e) {
+      for (size_t i = b; i < e; i++)
+        out[i] = norm(ps[i][0], ps[i][1], ps[i][2]);
+    });
+  }
+  return Py::Array<float>::make(std::move(out));
+}
 
-  // >>> vec.Vec(i,j,k)
-  PyObject *val = Py::BuildValue(i, j, k);
-  PyObject *ret = PyVec::make(val);
-  Py_DECREF(val);
+/// Computes `m p + t` for every point, in parallel, into a new `Array<Vec>`.
+static PyObject *transform_points(const Points &ps, const float (&m)[9],
+                                  const Vec &t)
+{
+  std::vector<Vec> out(ps.n);
+  {
+    Py::AllowThreads nogil;
+    Py::parallel_for(ps.n, reduce_grain, [&](size_t b, size_t e) {
+      for (size_t i = b; i < e; i++) {
+        const float *p = ps[i];
+        out[i] = {m[0]*p[0] + m[1]*p[1] + m[2]*p[2] + t.x,
+                  m[3]*p[0] + m[4]*p[1] + m[5]*p[2] + t.y,
+                  m[6]*p[0] + m[7]*p[1] + m[8]*p[2] + t.z};
+      }
+    });
+  }
+  return Py::Array<Vec>::make(std::move(out));
+}
 
-  return ret;
+/// >>> vec.transform(points, rows)          # rows: 3 Vecs, or 9 floats
+/// >>> vec.transform(points, rows, offset)  # then adds the Vec offset
+PyObject *transform(PyObject *, PyObject *args)
+{
+  PyObject *o, *rows;
+  Vec t = {0, 0, 0};
+  Points ps, m;
+  if (!Py::ParseTuple(args, o, rows, Py::Optional(), t) || !ps.fill(o) ||
+      !m.fill(rows))
+    return nullptr;
+  if (m.n != 3) {
+    PyErr_SetString(PyExc_ValueError, "a 3x3 matrix needs three rows");
+    return nullptr;
+  }
+
+  float mat[9];
+  std::copy(m.data, m.data + 9, mat);
+  return transform_points(ps, mat, t);
+}
+
+/// >>> vec.rotate(points, (w, x, y, z))  # by a unit quaternion
+PyObject *rotate(PyObject *, PyObject *args)
+{
+  PyObject *o;
+  float w, x, y, z;
+  auto q = std::tie(w, x, y, z);
+  Points ps;
+  if (!Py::ParseTuple(args, o, q) || !ps.fill(o))
+    return nullptr;
+
+  float n = std::sqrt(w*w + x*x + y*y + z*z);
+  if (n == 0) {
+    PyErr_SetString(PyExc_ValueError, "zero quaternion");
+    return nullptr;
+  }
+  w /= n; x /= n; y /= n; z /= n;
+
+  const float mat[9] = {
+    1 - 2*(y*y + z*z), 2*(x*y - w*z),     2*(x*z + w*y),
+    2*(x*y + w*z),     1 - 2*(x*x + z*z), 2*(y*z - w*x),
+    2*(x*z - w*y),     2*(y*z + w*x),     1 - 2*(x*x + y*y),
+  };
+  return transform_points(ps, mat, Vec{0, 0, 0});
+}
+
+/// `m p + t` for a fixed matrix and offset. Calling a `vec.Affine` goes
+/// straight to `operator()`.
+struct Affine
+{
+  float m[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+  Vec t = {0, 0, 0};
+
+  Vec operator() (const Vec &p) const
+  {
+    return {m[0]*p.x + m[1]*p.y + m[2]*p.z + t.x,
+            m[3]*p.x + m[4]*p.y + m[5]*p.z + t.y,
+            m[6]*p.x + m[7]*p.y + m[8]*p.z + t.z};
+  }
+};
+
+using PyAffine = Py::Extention<Affine>;
+
+/// >>> f = vec.Affine(rows, offset)
+/// >>> f(vec.Vec(1, 2, 3))
+int init_affine(PyObject *self, PyObject *args, PyObject *)
+{
+  PyObject *rows;
+  Affine a;
+  Points m;
+  if (!Py::ParseTuple(args, rows, Py::Optional(), a.t) || !m.fill(rows))
+    return -1;
+  if (m.n != 3) {
+    PyErr_SetString(PyExc_ValueError, "a 3x3 matrix needs three rows");
+    return -1;
+  }
+  std::copy(m.data, m.data + 9, a.m);
+
+  Py::CriticalSection lock(self);
+  ((PyAffine *) self)->get() = a;
+  return 0;
+}
+
+/// >>> vec.load_text("points.csv")     # x, y, z per line, or x y z
+/// >>> vec.load_text(path, 1, ";")      # skips a header line
+/// The points as a VecArray, parsed in parallel a chunk at a time.
+PyObject *load_text(PyObject *, PyObject *args)
+{
+  PyObject *path;
+  Py_ssize_t skip = 0;
+  const char *delimiter = ",";
+  if (!Py::ParseTuple(args, path, Py::Optional(), skip, delimiter))
+    return nullptr;
+  if (skip < 0 || std::strlen(delimiter) != 1) {
+    PyErr_SetString(PyExc_ValueError,
+                    "expected skip >= 0 and a one-character delimiter");
+    return nullptr;
+  }
+
+  Py::TextFormat fmt;
+  fmt.skip = skip;
+  fmt.delimiter = delimiter[0];
+  std::vector<Vec> vs;
+  if (!Py::load_text(path, vs, fmt))
+    return nullptr;
+  return Py::Array<Vec>::make(std::move(vs));
+}
+
+/// >>> vec.load_binary("points.f32")         # packed float x, y, z
+/// >>> vec.load_binary(path, 16, 4, header)  # 16-byte records, xyz at 4
+PyObject *load_binary(PyObject *, PyObject *args)
+{
+  PyObject *path;
+  Py_ssize_t record = sizeof(Vec), offset = 0, header = 0;
+  if (!Py::ParseTuple(args, path, Py::Optional(), record, offset, header))
+    return nullptr;
+  if (record <= 0 || offset < 0 || header < 0) {
+    PyErr_SetString(PyExc_ValueError,
+                    "expected record > 0, offset >= 0 and header >= 0");
+    return nullptr;
+  }
+
+  Py::RecordFormat fmt;
+  fmt.record = record;
+  fmt.offset = offset;
+  fmt.header = header;
+  std::vector<Vec> vs;
+  if (!Py::load_records(path, vs, fmt))
+    return nullptr;
+  return Py::Array<Vec>::make(std::move(vs));
 }
 
 static PyMethodDef vecMethods[] = {
+  Py::MethodDef("cross", "The cross product of two Vecs.",
+                PYXX_BIND(cross)::call),
+  Py::MethodDef("cross_map",
+                "cross over [(a, b), ...], or over columns as (as, bs).",
+                PYXX_MAP_NOGIL(cross)::call),
+  Py::MethodDef("norm", "The length of (x, y, z).",
+                PYXX_BIND(norm)::call),
+  Py::MethodDef("norms", "norm over float buffers, like a ufunc; takes out=.",
+                PYXX_VECTORIZE(norm)::call),
+  Py::MethodDef("sum", "sum(points, precise=False): the sum as a Vec.",
+                sum),
+  Py::MethodDef("centroid", "The mean of a set of points.", centroid),
+  Py::MethodDef("bounds", "The (lo, hi) corners of the bounding box.",
+                bounds),
+  Py::MethodDef("lengths", "The length of each point, as an Array of float.",
+                lengths),
+  Py::MethodDef("transform", "transform(points, rows, offset=Vec(0, 0, 0)).",
+                transform),
+  Py::MethodDef("rotate", "rotate(points, (w, x, y, z)) by a quaternion.",
+                rotate),
+  Py::MethodDef("load_text",
+                "load_text(path, skip=0, delimiter=','): points from text.",
+                load_text),
+  Py::MethodDef("load_binary",
+                "load_binary(path, record=12, offset=0, header=0).",
+                load_binary),
+  Py::MethodDef("trace_start", "Starts tracing native calls.",
+                Py::trace_start),
+  Py::MethodDef("trace_stop", "trace_stop(clear=False): stops tracing.",
+                Py::trace_stop),
+  Py::MethodDef("trace_dump", "The trace so far, as Chrome trace JSON.",
+                Py::trace_dump),
+  Py::MethodDef("type_stats",
+                "{type: (live, created, bytes)} for every C++ type.",
+                Py::type_stats),
+  Py::MethodDef("lazy", "Defers arithmetic on a Vec until it is needed.",
+                lazy),
   {NULL, NULL, 0, NULL}
 };
 
-PyMODINIT_FUNC initvec()
+static PyObject *make_vec(const Vec &v)
+{
+  return PyVec::make(v);
+}
+
+static int exec_vec(PyObject *m)
 {
   PyVec::type.tp_name = "vec.Vec";
   Py::Register(PyVec::type.tp_init, init_vec);
   Py::Register(PyVec::type.tp_str, vec_str);
   Py::Register(PyVec::type.tp_repr, vec_str);
   PyVec::type.tp_as_number = &PyVec::numMethods;
+  Py::Fields<Vec>(PyVec::type, PYXX_FIELD(Vec, x, "The x component."),
+                  PYXX_FIELD(Vec, y), PYXX_FIELD(Vec, z));
   if (PyType_Ready(&PyVec::type) < 0)
-    return;
+    return -1;
+  if (LazyVec::Ready("vec.LazyVec") < 0)
+    return -1;
+
+  static PySequenceMethods kdtreeSeq = { };
+  kdtreeSeq.sq_length = kdtree_len;
+  PyKDTree::type.tp_name = "vec.KDTree";
+  PyKDTree::type.tp_new = new_kdtree;
+  PyKDTree::type.tp_methods = kdtreeMethods;
+  PyKDTree::type.tp_as_sequence = &kdtreeSeq;
+  if (PyType_Ready(&PyKDTree::type) < 0)
+    return -1;
+  if (Py::Array<Vec>::Ready("vec.VecArray") < 0)
+    return -1;
+  if (Py::Array<float>::Ready() < 0)
+    return -1;
+  if (Py::Array<Py_ssize_t>::Ready() < 0)
+    return -1;
 
-  PyObject *m = Py_InitModule("vec", vecMethods);
-  if (!m)
-    return;
+  PyVec4::type.tp_name = "vec.Vec4";
+  Py::Register(PyVec4::type.tp_init, init_vec4);
+  PyVec4::type.tp_as_number = &PyVec4::numMethods;
+  PyVec4::type.tp_methods = vec4Methods;
+  Py::Fields<Vec4>(PyVec4::type, PYXX_FIELD(Vec4, x), PYXX_FIELD(Vec4, y),
+                   PYXX_FIELD(Vec4, z), PYXX_FIELD(Vec4, w));
+  if (PyType_Ready(&PyVec4::type) < 0)
+    return -1;
+
+  PyAffine::type.tp_name = "vec.Affine";
+  Py::Register(PyAffine::type.tp_init, init_affine);
+  if (PyType_Ready(&PyAffine::type) < 0)
+    return -1;
 
   Py_INCREF(&PyVec::type);
   PyModule_AddObject(m, "Vec", (PyObject *) &PyVec::type);
+  Py_INCREF(&LazyVec::type);
+  PyModule_AddObject(m, "LazyVec", (PyObject *) &LazyVec::type);
+  Py_INCREF(&PyKDTree::type);
+  PyModule_AddObject(m, "KDTree", (PyObject *) &PyKDTree::type);
+  Py_INCREF(&PyVec4::type);
+  PyModule_AddObject(m, "Vec4", (PyObject *) &PyVec4::type);
+  Py_INCREF(&PyAffine::type);
+  PyModule_AddObject(m, "Affine", (PyObject *) &PyAffine::type);
+
+  VecApi api = { &PyVec::type, make_vec, cross, norm };
+  return Py::export_api(m, api);
 }
 
+PYXX_MODULE(vec, vecMethods, exec_vec)
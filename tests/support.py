@@ -0,0 +1,25 @@
+"""Shared setup for the sample module tests.
+
+The tests import the modules built from ../samples. Build them first:
+
+    cd samples && python setup.py build_ext --inplace
+    cd .. && python -m unittest discover -s tests
+
+Modules on PYTHONPATH take precedence over the ones in ../samples, so the
+same tests can run against builds for several interpreters.
+"""
+
+import os
+import sys
+
+SAMPLES = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                       os.pardir, 'samples')
+if SAMPLES not in sys.path:
+    sys.path.append(SAMPLES)
+
+
+def assertVec(test, v, x, y, z, places=5):
+    """Checks the components of a Vec (or anything with x, y and z)."""
+    test.assertAlmostEqual(v.x, x, places=places)
+    test.assertAlmostEqual(v.y, y, places=places)
+    test.assertAlmostEqual(v.z, z, places=places)
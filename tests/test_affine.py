@@ -0,0 +1,43 @@
+import unittest
+
+import support
+import vec
+
+V = vec.Vec
+
+
+class AffineTest(unittest.TestCase):
+
+    def setUp(self):
+        self.f = vec.Affine([V(0, 1, 0), V(1, 0, 0), V(0, 0, 2)], V(1, 1, 1))
+
+    def test_call(self):
+        support.assertVec(self, self.f(V(1, 2, 3)), 3, 2, 7)
+        identity = vec.Affine([V(1, 0, 0), V(0, 1, 0), V(0, 0, 1)])
+        support.assertVec(self, identity(V(1, 2, 3)), 1, 2, 3)
+
+    def test_tp_call(self):
+        # Through the type's __call__, rather than the vectorcall slot.
+        support.assertVec(self, type(self.f).__call__(self.f, V(1, 2, 3)),
+                          3, 2, 7)
+        support.assertVec(self, self.f(*[V(1, 2, 3)]), 3, 2, 7)
+
+    def test_wrong_arity(self):
+        self.assertRaises(TypeError, self.f)
+        self.assertRaises(TypeError, self.f, V(1, 2, 3), V(1, 2, 3))
+
+    def test_keywords(self):
+        self.assertRaises(TypeError, lambda: self.f(p=V(1, 2, 3)))
+        self.assertRaises(TypeError, lambda: self.f(V(1, 2, 3), p=1))
+
+    def test_wrong_type(self):
+        self.assertRaises(TypeError, self.f, 1)
+        self.assertRaises(TypeError, self.f, (1, 2, 3))
+
+    def test_bad_matrix(self):
+        self.assertRaises(ValueError, vec.Affine, [V(1, 0, 0)])
+        self.assertRaises(TypeError, vec.Affine, [(1, 0, 0)] * 3)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,44 @@
+import unittest
+
+import support
+import vec
+
+
+class AlignedTest(unittest.TestCase):
+
+    def test_alignment(self):
+        vs = [vec.Vec4(i, i + 1, i + 2, i + 3) for i in range(100)]
+        for v in vs:
+            self.assertTrue(v.aligned())
+        # Arithmetic results come from the same allocator.
+        for v in [vs[0] + vs[1], vs[5] - vs[2]]:
+            self.assertTrue(v.aligned())
+
+    def test_values(self):
+        a = vec.Vec4(1, 2, 3, 4)
+        b = vec.Vec4(0.5, 0.5, 0.5, 0.5)
+        s = a + b
+        self.assertEqual((s.x, s.y, s.z, s.w), (1.5, 2.5, 3.5, 4.5))
+        d = a - b
+        self.assertEqual((d.x, d.y, d.z, d.w), (0.5, 1.5, 2.5, 3.5))
+        a.w = 10
+        self.assertEqual(a.w, 10.0)
+
+    def test_sizeof(self):
+        self.assertEqual(vec.Vec4(1, 2, 3, 4).__sizeof__() % 32, 0)
+
+    def test_errors(self):
+        self.assertRaises(TypeError, vec.Vec4, 1, 2, 3)
+        self.assertRaises(TypeError, lambda: vec.Vec4(1, 2, 3, 4) + 1)
+        self.assertRaises(TypeError,
+                          lambda: vec.Vec4(1, 2, 3, 4) + vec.Vec(1, 2, 3))
+
+    def test_not_subclassable(self):
+        def subclass():
+            class Sub(vec.Vec4):
+                pass
+        self.assertRaises(TypeError, subclass)
+
+
+if __name__ == '__main__':
+    unittest.main()
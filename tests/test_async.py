@@ -0,0 +1,38 @@
+import unittest
+
+import support
+import cpp
+
+
+class AsyncTest(unittest.TestCase):
+
+    def test_result(self):
+        t = cpp.async_primes(30)
+        self.assertIsInstance(t, cpp.Task)
+        self.assertTrue(t.wait())
+        self.assertTrue(t.done())
+        self.assertEqual(t.result(), [2, 3, 5, 7, 11, 13, 17, 19, 23, 29])
+        self.assertEqual(t.result(), [2, 3, 5, 7, 11, 13, 17, 19, 23, 29])
+
+    def test_wait_timeout(self):
+        t = cpp.async_primes(100)
+        self.assertTrue(t.wait(30.0))
+        self.assertFalse(t.cancel())
+        self.assertEqual(len(t.result()), 25)
+
+    def test_many_tasks(self):
+        tasks = [cpp.async_primes(n) for n in range(50)]
+        counts = [len(t.result()) for t in tasks]
+        self.assertEqual(counts[:8], [0, 0, 0, 1, 2, 2, 3, 3])
+        self.assertEqual(counts[-1], 15)
+
+    def test_bad_arguments(self):
+        self.assertRaises(TypeError, cpp.async_primes, 'ten')
+        self.assertRaises(TypeError, cpp.async_primes)
+        t = cpp.async_primes(10)
+        self.assertRaises(TypeError, t.wait, 'soon')
+        t.result()
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,37 @@
+import array
+import sys
+import unittest
+
+import support
+import cpp
+
+
+class BufferTest(unittest.TestCase):
+
+    def test_count_lines(self):
+        text = b'one\ntwo\nthree\n'
+        self.assertEqual(cpp.count_lines(text), 3)
+        self.assertEqual(cpp.count_lines(bytearray(text)), 3)
+        self.assertEqual(cpp.count_lines(memoryview(text)), 3)
+        self.assertEqual(cpp.count_lines(memoryview(text)[4:]), 2)
+        self.assertEqual(cpp.count_lines(b''), 0)
+
+    @unittest.skipIf(sys.version_info[0] < 3, 'str is bytes on Python 2')
+    def test_count_lines_str(self):
+        self.assertEqual(cpp.count_lines(u'\xe9\n\xe8\n'), 2)
+
+    def test_count_lines_bad_buffer(self):
+        self.assertRaises(TypeError, cpp.count_lines, 12)
+        self.assertRaises(TypeError, cpp.count_lines, None)
+        self.assertRaises((TypeError, ValueError, BufferError),
+                          cpp.count_lines, array.array('i', [10, 10]))
+
+    def test_bytearray_stays_resizable(self):
+        data = bytearray(b'a\nb\n')
+        self.assertEqual(cpp.count_lines(data), 2)
+        data.extend(b'c\n' * 1000)
+        self.assertEqual(cpp.count_lines(data), 1002)
+
+
+if __name__ == '__main__':
+    unittest.main()
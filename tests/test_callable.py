@@ -0,0 +1,50 @@
+import operator
+import unittest
+
+import support
+import cpp
+
+
+class CallableTest(unittest.TestCase):
+
+    def setUp(self):
+        self.xs = cpp.Ints(list(range(-5, 20)))
+
+    def test_kinds_of_callable(self):
+        odd = [x for x in range(-5, 20) if x % 2]
+        self.assertEqual(self.xs.filter(lambda x: x % 2), odd)
+
+        def is_odd(x):
+            return x % 2 == 1
+        self.assertEqual(self.xs.filter(is_odd), odd)
+        self.assertEqual(self.xs.filter(bool),
+                         [x for x in range(-5, 20) if x])
+        self.assertEqual(self.xs.filter({4: 1, 7: 1}.get), [4, 7])
+        self.assertEqual(self.xs.filter(operator.not_), [0])
+
+    def test_holding_on_to_arguments(self):
+        seen = []
+
+        def keep_all(*args):
+            seen.append(args)
+            return True
+        self.assertEqual(len(self.xs.filter(keep_all)), 25)
+        self.assertEqual(seen, [(x,) for x in range(-5, 20)])
+
+    def test_truthiness(self):
+        self.assertEqual(self.xs.filter(lambda x: [x] if x > 17 else []),
+                         [18, 19])
+
+    def test_errors(self):
+        self.assertRaises(TypeError, self.xs.filter, 5)
+        self.assertRaises(TypeError, self.xs.filter, lambda: True)
+
+        def boom(x):
+            if x == 3:
+                raise KeyError(x)
+            return True
+        self.assertRaises(KeyError, self.xs.filter, boom)
+
+
+if __name__ == '__main__':
+    unittest.main()
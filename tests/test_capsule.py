@@ -0,0 +1,52 @@
+import os
+import subprocess
+import sys
+import unittest
+
+import support
+import cpp
+import vec
+
+
+def run_fresh(code):
+    """Runs `code` in a new interpreter, with this one's module path."""
+    env = dict(os.environ)
+    env['PYTHONPATH'] = os.pathsep.join(p for p in sys.path if p)
+    out = subprocess.check_output([sys.executable, '-c', code], env=env)
+    return out.decode().strip()
+
+
+class CapsuleTest(unittest.TestCase):
+
+    def test_as_vec(self):
+        v = cpp.Ints([1, 2, 3, 4]).as_vec()
+        self.assertIsInstance(v, vec.Vec)
+        support.assertVec(self, v, 1, 2, 3)
+        support.assertVec(self, cpp.Ints([5]).as_vec(), 5, 0, 0)
+
+    def test_dot(self):
+        self.assertEqual(cpp.Ints([1, 2, 3]).dot(vec.Vec(1, 0, 1)), 4.0)
+        self.assertRaises(TypeError, cpp.Ints([1, 2, 3]).dot, (1, 0, 1))
+
+    def test_capsule(self):
+        self.assertEqual(type(vec._C_API).__name__, 'PyCapsule')
+
+    def test_imports_on_first_use(self):
+        out = run_fresh('import sys, cpp\n'
+                        'print("vec" in sys.modules)\n'
+                        'cpp.Ints([1, 2, 3]).as_vec()\n'
+                        'print("vec" in sys.modules)\n')
+        self.assertEqual(out.split(), ['False', 'True'])
+
+    def test_missing_module(self):
+        out = run_fresh('import sys, cpp\n'
+                        'sys.modules["vec"] = None\n'
+                        'try:\n'
+                        '    cpp.Ints([1]).as_vec()\n'
+                        'except ImportError:\n'
+                        '    print("ImportError")\n')
+        self.assertEqual(out, 'ImportError')
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,38 @@
+import unittest
+
+import support
+import vec
+
+
+class FieldsTest(unittest.TestCase):
+
+    def test_get_set(self):
+        v = vec.Vec(1, 2, 3)
+        self.assertEqual((v.x, v.y, v.z), (1.0, 2.0, 3.0))
+        v.y = 7.5
+        v.z = 2
+        support.assertVec(self, v, 1, 7.5, 2)
+
+    def test_doc(self):
+        self.assertEqual(vec.Vec.x.__doc__, 'The x component.')
+        self.assertIsNone(vec.Vec.y.__doc__)
+
+    def test_bad_values(self):
+        v = vec.Vec(1, 2, 3)
+
+        def set_str():
+            v.x = 'one'
+        self.assertRaises(TypeError, set_str)
+
+        def delete():
+            del v.y
+        self.assertRaises(TypeError, delete)
+        support.assertVec(self, v, 1, 2, 3)
+
+    def test_unknown_attribute(self):
+        v = vec.Vec(1, 2, 3)
+        self.assertRaises(AttributeError, getattr, v, 'w')
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,51 @@
+import itertools
+import threading
+import unittest
+
+import support
+import cpp
+
+
+def primes_under(n):
+    return [p for p in range(2, n) if all(p % d for d in range(2, p))]
+
+
+class GeneratorTest(unittest.TestCase):
+
+    def test_bounded(self):
+        g = cpp.iter_primes(20)
+        self.assertEqual(type(g).__name__, 'Generator')
+        self.assertIs(iter(g), g)
+        self.assertEqual(list(g), [2, 3, 5, 7, 11, 13, 17, 19])
+        self.assertEqual(list(g), [])
+        self.assertRaises(StopIteration, next, g)
+
+    def test_unbounded(self):
+        first = list(itertools.islice(cpp.iter_primes(), 3000))
+        self.assertEqual(first[:200], primes_under(1224))
+        self.assertEqual(len(first), 3000)
+
+    def test_shared_between_threads(self):
+        g = cpp.iter_primes(50000)
+        seen = [[] for i in range(4)]
+
+        def drain(out):
+            for p in g:
+                out.append(p)
+        threads = [threading.Thread(target=drain, args=(s,)) for s in seen]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        got = sorted(p for s in seen for p in s)
+        self.assertEqual(got, list(cpp.iter_primes(50000)))
+        for s in seen:
+            self.assertEqual(s, sorted(s))
+
+    def test_bad_arguments(self):
+        self.assertRaises(TypeError, cpp.iter_primes, 'ten')
+        self.assertRaises(TypeError, cpp.iter_primes, 1, 2)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,98 @@
+import random
+import unittest
+
+import support
+import cpp
+
+# Past the parallel grain, so the chunked paths run too.
+N = 200000
+
+
+class IntsTest(unittest.TestCase):
+
+    def setUp(self):
+        rng = random.Random(44)
+        self.values = [rng.randint(-1000, 1000) for i in range(N)]
+
+    def test_sort(self):
+        xs = cpp.Ints([3, 1, 2])
+        self.assertIsNone(xs.sort())
+        self.assertEqual(str(xs), '[1, 2, 3]')
+        xs = cpp.Ints(self.values)
+        xs.sort()
+        self.assertEqual(str(xs), str(cpp.Ints(sorted(self.values))))
+        cpp.Ints([]).sort()
+
+    def test_argsort(self):
+        self.assertEqual(list(cpp.Ints([30, 10, 20, 10]).argsort()), [1, 3, 2, 0])
+        order = list(cpp.Ints(self.values).argsort())
+        expect = sorted(range(N), key=lambda i: self.values[i])
+        self.assertEqual(order, expect)
+        self.assertEqual(list(cpp.Ints([]).argsort()), [])
+
+    def test_searchsorted(self):
+        xs = cpp.Ints([1, 3, 3, 7])
+        self.assertEqual(xs.searchsorted(3), 1)
+        self.assertEqual(xs.searchsorted(3, True), 3)
+        self.assertEqual(list(xs.searchsorted([0, 4, 9])), [0, 3, 4])
+        self.assertEqual(list(xs.searchsorted([3, 3], True)), [3, 3])
+        self.assertEqual(list(xs.searchsorted([])), [])
+        self.assertRaises(TypeError, xs.searchsorted, 'x')
+        self.assertRaises(TypeError, xs.searchsorted, [1, 'x'])
+        self.assertRaises(TypeError, xs.searchsorted)
+
+    def test_unique(self):
+        self.assertEqual(str(cpp.Ints([3, 1, 3, 2, 1]).unique()), '[1, 2, 3]')
+        u = cpp.Ints(self.values).unique()
+        self.assertEqual(str(u), str(cpp.Ints(sorted(set(self.values)))))
+
+    def test_cumsum(self):
+        self.assertEqual(list(cpp.Ints([1, 2, 3]).cumsum()), [1, 3, 6])
+        self.assertEqual(list(cpp.Ints([]).cumsum()), [])
+        big = 2 ** 31 - 1
+        self.assertEqual(list(cpp.Ints([big, big]).cumsum()), [big, 2 * big])
+        sums = list(cpp.Ints(self.values).cumsum())
+        for i in (0, 1, N // 2, N - 1):
+            self.assertEqual(sums[i], sum(self.values[:i + 1]))
+
+    def test_topk(self):
+        self.assertEqual(str(cpp.Ints([5, 1, 9, 3]).topk(2)), '[9, 5]')
+        self.assertEqual(str(cpp.Ints([5, 1]).topk(5)), '[5, 1]')
+        self.assertEqual(str(cpp.Ints([5, 1]).topk(0)), '[]')
+        top = cpp.Ints(self.values).topk(10)
+        self.assertEqual(str(top), str(cpp.Ints(sorted(self.values)[::-1][:10])))
+        self.assertRaises(ValueError, cpp.Ints([1]).topk, -1)
+        self.assertRaises(TypeError, cpp.Ints([1]).topk)
+
+    def test_histogram(self):
+        self.assertEqual(list(cpp.Ints([0, 1, 2, 3, 9]).histogram(2)), [4, 1])
+        self.assertEqual(list(cpp.Ints([0, 1, 2, 3, 9]).histogram(2, 0, 3)), [2, 2])
+        self.assertEqual(list(cpp.Ints([]).histogram(3)), [0, 0, 0])
+        counts = list(cpp.Ints(self.values).histogram(4))
+        self.assertEqual(len(counts), 4)
+        self.assertEqual(sum(counts), N)
+        self.assertRaises(TypeError, cpp.Ints([1]).histogram, 2, 0)
+        self.assertRaises(ValueError, cpp.Ints([1]).histogram, 0)
+        self.assertRaises(ValueError, cpp.Ints([1]).histogram, 2, 5, 1)
+
+    def test_histogram_many_bins(self):
+        # More bins than a chunk's items: counted in one pass.
+        bins = 100000
+        counts = list(cpp.Ints(self.values).histogram(bins, -1000, 1000))
+        expect = [0] * bins
+        for v in self.values:
+            expect[(v + 1000) * bins // 2001] += 1
+        self.assertEqual(counts, expect)
+        # The full int range, where (x - lo) * bins needs more than 64 bits.
+        counts = cpp.Ints([-2 ** 31, 0, 2 ** 31 - 1]).histogram(2 ** 20)
+        self.assertEqual((counts[0], counts[2 ** 19], counts[2 ** 20 - 1]),
+                         (1, 1, 1))
+        self.assertEqual(sum(counts), 3)
+
+    def test_histogram_too_many_bins(self):
+        self.assertRaises(MemoryError, cpp.Ints([1, 2, 3]).histogram, 2 ** 62)
+        self.assertRaises(MemoryError, cpp.Ints([]).histogram, 2 ** 62)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,109 @@
+import array
+import random
+import sys
+import threading
+import unittest
+
+import support
+import vec
+
+
+def dist2(p, q):
+    return sum((a - b) ** 2 for a, b in zip(p, q))
+
+
+class KDTreeTest(unittest.TestCase):
+
+    def setUp(self):
+        rng = random.Random(36)
+        self.pts = [(rng.uniform(-1, 1), rng.uniform(-1, 1),
+                     rng.uniform(-1, 1)) for i in range(300)]
+        self.vecs = [vec.Vec(*p) for p in self.pts]
+        # Round through float32, as the tree stores them.
+        self.pts = [(v.x, v.y, v.z) for v in self.vecs]
+        self.tree = vec.KDTree(self.vecs)
+
+    def test_len(self):
+        self.assertEqual(len(self.tree), 300)
+        self.assertEqual(len(vec.KDTree([])), 0)
+
+    def test_nearest(self):
+        q = (0.1, -0.2, 0.3)
+        got = list(self.tree.nearest(vec.Vec(*q), 5))
+        expect = sorted(range(300), key=lambda i: dist2(self.pts[i], q))[:5]
+        self.assertEqual(got, expect)
+
+    def test_nearest_pads(self):
+        tree = vec.KDTree([vec.Vec(0, 0, 0), vec.Vec(1, 1, 1)])
+        self.assertEqual(list(tree.nearest(vec.Vec(1, 1, 1), 4)),
+                         [1, 0, -1, -1])
+
+    def test_nearest_too_many(self):
+        tree = vec.KDTree([vec.Vec(0, 0, 0), vec.Vec(1, 1, 1)])
+        self.assertRaises(MemoryError, tree.nearest, vec.Vec(0, 0, 0), 2 ** 62)
+        self.assertRaises(ValueError, tree.nearest, vec.Vec(0, 0, 0), -1)
+        self.assertEqual(list(tree.nearest(vec.Vec(0, 0, 0), 0)), [])
+
+    def test_within(self):
+        q = (0, 0, 0)
+        got = list(self.tree.within(vec.Vec(*q), 0.5))
+        expect = [i for i in range(300) if dist2(self.pts[i], q) <= 0.25]
+        self.assertEqual(got, expect)
+
+    def test_within_bad_radius(self):
+        self.assertRaises(ValueError, self.tree.within, vec.Vec(0, 0, 0), -2.0)
+        self.assertRaises(ValueError, self.tree.within, vec.Vec(0, 0, 0),
+                          float('nan'))
+        self.assertEqual(list(self.tree.within(vec.Vec(5, 5, 5), 0)), [])
+
+    def test_in_box(self):
+        got = list(self.tree.in_box(vec.Vec(0, 0, 0), vec.Vec(1, 1, 1)))
+        expect = [i for i, p in enumerate(self.pts)
+                  if all(0 <= c <= 1 for c in p)]
+        self.assertEqual(got, expect)
+
+    @unittest.skipIf(sys.version_info[0] < 3,
+                     'array.array has no new-style buffer on Python 2')
+    def test_buffer_queries(self):
+        flat = array.array('f', [c for p in self.pts for c in p])
+        tree = vec.KDTree(flat)
+        qs = array.array('f', [0, 0, 0, 0.5, 0.5, 0.5])
+        near = list(tree.nearest(qs, 2))
+        self.assertEqual(near[:2], list(tree.nearest(vec.Vec(0, 0, 0), 2)))
+        idx, offsets = tree.within(qs, 0.3)
+        offsets = list(offsets)
+        self.assertEqual(len(offsets), 3)
+        self.assertEqual(list(idx)[offsets[0]:offsets[1]],
+                         list(tree.within(vec.Vec(0, 0, 0), 0.3)))
+        self.assertRaises(ValueError, vec.KDTree, array.array('f', [1, 2]))
+
+    def test_reinit_does_not_rebuild(self):
+        tree = vec.KDTree(self.vecs)
+        tree.__init__([vec.Vec(0, 0, 0)])
+        self.assertEqual(len(tree), 300)
+
+    def test_concurrent_queries(self):
+        expect = list(self.tree.nearest(vec.Vec(0, 0, 0), 3))
+        results = []
+
+        def query():
+            for i in range(50):
+                results.append(list(self.tree.nearest(vec.Vec(0, 0, 0), 3)))
+        threads = [threading.Thread(target=query) for i in range(4)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        self.assertEqual(results, [expect] * 200)
+
+    def test_errors(self):
+        self.assertRaises(TypeError, vec.KDTree)
+        self.assertRaises(TypeError, vec.KDTree, [vec.Vec(0, 0, 0), 1])
+        self.assertRaises(TypeError, vec.KDTree, 5)
+        self.assertRaises(ValueError, self.tree.nearest, vec.Vec(0, 0, 0), -1)
+        self.assertRaises(TypeError, self.tree.within, vec.Vec(0, 0, 0))
+        self.assertRaises(TypeError, self.tree.in_box, 1, 2)
+
+
+if __name__ == '__main__':
+    unittest.main()
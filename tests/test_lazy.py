@@ -0,0 +1,79 @@
+import unittest
+
+import support
+import vec
+
+
+class LazyTest(unittest.TestCase):
+
+    def setUp(self):
+        self.a = vec.Vec(1, 2, 3)
+        self.b = vec.Vec(4, 5, 6)
+        self.c = vec.Vec(-1, 0, 2)
+
+    def test_matches_eager(self):
+        a, b, c = self.a, self.b, self.c
+        lazy = (vec.lazy(a) + b - c) ^ -b
+        eager = (a + b - c) ^ -b
+        self.assertIsInstance(lazy, vec.LazyVec)
+        v = lazy.eval()
+        self.assertIsInstance(v, vec.Vec)
+        support.assertVec(self, v, eager.x, eager.y, eager.z)
+
+    def test_attribute_and_str_evaluate(self):
+        lazy = vec.lazy(self.a) + self.b
+        self.assertEqual(lazy.x, 5)
+        self.assertEqual(str(lazy), str(self.a + self.b))
+
+    def test_leaves_are_copies(self):
+        a = vec.Vec(1, 2, 3)
+        lazy = vec.lazy(a) + self.b
+        a += self.b
+        support.assertVec(self, lazy.eval(), 5, 7, 9)
+
+    def test_dot_is_eager(self):
+        self.assertEqual(vec.lazy(self.a) * self.b, 32.0)
+
+    def test_lazy_on_right(self):
+        lazy = vec.lazy(self.a)
+        support.assertVec(self, (lazy - lazy).eval(), 0, 0, 0)
+        support.assertVec(self, (vec.lazy(self.b) - lazy).eval(), 3, 3, 3)
+
+    def test_inplace_appends_to_self(self):
+        lazy = vec.lazy(self.a)
+        alias = lazy
+        lazy += self.b
+        lazy -= vec.lazy(self.c)
+        self.assertIs(lazy, alias)
+        support.assertVec(self, lazy.eval(), 6, 7, 7)
+
+    def test_long_accumulation(self):
+        total = vec.lazy(vec.Vec(0, 0, 0))
+        for i in range(1000):
+            total += self.a
+        support.assertVec(self, total.eval(), 1000, 2000, 3000)
+
+        total = vec.lazy(vec.Vec(0, 0, 0))
+        for i in range(1000):
+            total = total + self.a
+        support.assertVec(self, total.eval(), 1000, 2000, 3000)
+
+    def test_eval_twice(self):
+        lazy = -(vec.lazy(self.a) + self.b)
+        support.assertVec(self, lazy.eval(), -5, -7, -9)
+        support.assertVec(self, lazy.eval(), -5, -7, -9)
+
+    def test_bad_operands(self):
+        lazy = vec.lazy(self.a)
+        self.assertRaises(TypeError, lambda: lazy + 1)
+        self.assertRaises(TypeError, lambda: 'x' - lazy)
+        self.assertRaises(TypeError, vec.lazy, 1)
+
+        def iadd():
+            l = vec.lazy(self.a)
+            l += 1
+        self.assertRaises(TypeError, iadd)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,29 @@
+import unittest
+
+import support
+import cpp
+
+
+class ListTest(unittest.TestCase):
+
+    def test_extend(self):
+        self.assertEqual(cpp.list_primes(20), [2, 3, 5, 7, 11, 13, 17, 19])
+        self.assertEqual(cpp.list_primes(0), [])
+        self.assertEqual(len(cpp.list_primes(100000)), 9592)
+
+    def test_back_inserter(self):
+        self.assertEqual(cpp.words('to be  or\tnot\n'),
+                         ['to', 'be', 'or', 'not'])
+        self.assertEqual(cpp.words(''), [])
+        self.assertEqual(len(cpp.words('x ' * 10000)), 10000)
+
+    def test_push_back(self):
+        self.assertEqual(cpp.primes(), [1, 3, 5, 7])
+
+    def test_bad_arguments(self):
+        self.assertRaises(TypeError, cpp.list_primes, 'ten')
+        self.assertRaises(TypeError, cpp.words, 5)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,123 @@
+import locale
+import os
+import shutil
+import struct
+import tempfile
+import unittest
+
+import support
+import vec
+
+
+class LoadTest(unittest.TestCase):
+
+    def setUp(self):
+        self.dir = tempfile.mkdtemp()
+
+    def tearDown(self):
+        shutil.rmtree(self.dir)
+
+    def write(self, data, name='points'):
+        path = os.path.join(self.dir, name)
+        with open(path, 'wb') as f:
+            f.write(data)
+        return path
+
+    def test_text(self):
+        path = self.write(b'x, y, z\n'
+                          b'1, 2, 3\n'
+                          b'\n'
+                          b'# a comment\n'
+                          b'  4 5 6  # trailing\n'
+                          b'-1.5e1,+2.25,inf\n')
+        vs = vec.load_text(path, 1)
+        self.assertEqual(len(vs), 3)
+        support.assertVec(self, vs[0], 1, 2, 3)
+        support.assertVec(self, vs[1], 4, 5, 6)
+        self.assertEqual((vs[2].x, vs[2].y, vs[2].z),
+                         (-15, 2.25, float('inf')))
+
+    def test_delimiter(self):
+        vs = vec.load_text(self.write(b'1;2;3\n4; 5 ;6'), 0, ';')
+        support.assertVec(self, vs[1], 4, 5, 6)
+        self.assertRaises(ValueError, vec.load_text, self.write(b''), 0, ';;')
+        self.assertRaises(ValueError, vec.load_text, self.write(b''), -1)
+
+    def test_long_numbers(self):
+        text = '0.1000000000000000055511151231257827, 1e-30, 123456789012345678'
+        v = vec.load_text(self.write(text.encode()))[0]
+        expect = struct.unpack('3f', struct.pack(
+            '3f', *[float(s) for s in text.split(',')]))
+        self.assertEqual((v.x, v.y, v.z), expect)
+
+    def test_bad_rows(self):
+        for text, error in [(b'1, 2, 3\n1, 2\n', 'line 2: too few values'),
+                            (b'1, 2, 3, 4\n', 'line 1: too many values'),
+                            (b'1, 2, 3\n\n1, x, 3\n', 'line 3: not a number')]:
+            with self.assertRaises(ValueError) as cm:
+                vec.load_text(self.write(text))
+            self.assertEqual(str(cm.exception), error)
+
+    def test_missing_file(self):
+        self.assertRaises(IOError, vec.load_text,
+                          os.path.join(self.dir, 'missing'))
+        self.assertRaises(IOError, vec.load_binary,
+                          os.path.join(self.dir, 'missing'))
+
+    def test_comma_locale(self):
+        for name in ('de_DE.UTF-8', 'fr_FR.UTF-8', 'de_DE', 'fr_FR'):
+            try:
+                old = locale.setlocale(locale.LC_NUMERIC, name)
+                break
+            except locale.Error:
+                pass
+        else:
+            self.skipTest('no locale with a decimal comma')
+        try:
+            text = b'0.1000000000000000055511151231257827 2.5 3'
+            v = vec.load_text(self.write(text))[0]
+        finally:
+            locale.setlocale(locale.LC_NUMERIC, old)
+        self.assertAlmostEqual(v.x, 0.1, places=6)
+
+    def test_packed(self):
+        n = 1000 * 1000  # Past one 8 MiB chunk.
+        path = self.write(struct.pack('3f', 1, 2, 3) * (n - 1) +
+                          struct.pack('3f', 4, 5, 6))
+        before = vec.type_stats().get('vec.VecArray', (0, 0, 0))[2]
+        vs = vec.load_binary(path)
+        self.assertEqual(len(vs), n)
+        support.assertVec(self, vs[0], 1, 2, 3)
+        support.assertVec(self, vs[n - 1], 4, 5, 6)
+        # Read into the exact reserve, not past it.
+        grown = vec.type_stats()['vec.VecArray'][2] - before
+        self.assertLess(grown, n * 12 + 4096)
+
+    def test_records(self):
+        data = b'HEAD' + b''.join(struct.pack('i3fi', i, i, 2 * i, 3 * i, -1)
+                                  for i in range(5))
+        vs = vec.load_binary(self.write(data), 20, 4, 4)
+        self.assertEqual(len(vs), 5)
+        support.assertVec(self, vs[4], 4, 8, 12)
+
+    def test_short_final_record(self):
+        data = struct.pack('3f', 1, 2, 3) * 3 + b'\0' * 5
+        with self.assertRaises(ValueError) as cm:
+            vec.load_binary(self.write(data))
+        self.assertEqual(str(cm.exception), 'file ends 5 bytes into a record')
+        with self.assertRaises(ValueError) as cm:
+            vec.load_binary(self.write(b'\0' * 30), 16)
+        self.assertEqual(str(cm.exception),
+                         'file ends 14 bytes into a record')
+
+    def test_bad_format(self):
+        path = self.write(b'\0' * 32)
+        self.assertRaises(ValueError, vec.load_binary, path, 16, 8)
+        self.assertRaises(ValueError, vec.load_binary, path, 8)
+        self.assertRaises(ValueError, vec.load_binary, path, 0)
+        self.assertRaises(ValueError, vec.load_binary, path, 12, -1)
+        self.assertEqual(len(vec.load_binary(path, 12, 0, 32)), 0)
+
+
+if __name__ == '__main__':
+    unittest.main()
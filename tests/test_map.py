@@ -0,0 +1,40 @@
+import unittest
+
+import support
+import vec
+
+
+class MapTest(unittest.TestCase):
+
+    def setUp(self):
+        self.x = vec.Vec(1, 0, 0)
+        self.y = vec.Vec(0, 1, 0)
+
+    def test_cross(self):
+        support.assertVec(self, vec.cross(self.x, self.y), 0, 0, 1)
+
+    def test_rows(self):
+        out = vec.cross_map([(self.x, self.y), (self.y, self.x)])
+        self.assertEqual(len(out), 2)
+        support.assertVec(self, out[0], 0, 0, 1)
+        support.assertVec(self, out[1], 0, 0, -1)
+
+    def test_columns(self):
+        out = vec.cross_map(iter([self.x, self.y]), (self.y, self.x))
+        support.assertVec(self, out[0], 0, 0, 1)
+        support.assertVec(self, out[1], 0, 0, -1)
+
+    def test_empty(self):
+        self.assertEqual(vec.cross_map([]), [])
+
+    def test_errors(self):
+        x, y = self.x, self.y
+        self.assertRaises(TypeError, vec.cross, x, 1)
+        self.assertRaises(TypeError, vec.cross_map, [(x,)])
+        self.assertRaises(TypeError, vec.cross_map, [(x, 1)])
+        self.assertRaises(TypeError, vec.cross_map, 5)
+        self.assertRaises(ValueError, vec.cross_map, [x], [y, x])
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,71 @@
+import threading
+import unittest
+
+import support
+import cpp
+
+
+class MemoTest(unittest.TestCase):
+
+    def setUp(self):
+        cpp.prime_count_cache_clear()
+
+    def test_prime_count(self):
+        self.assertEqual(cpp.prime_count(100), 25)
+        self.assertEqual(cpp.prime_count(100), 25)
+        self.assertEqual(cpp.prime_count(10), 4)
+        hits, misses, maxsize, size = cpp.prime_count_cache_info()
+        self.assertEqual((hits, misses, maxsize, size), (1, 2, 64, 2))
+
+    def test_clear_one(self):
+        cpp.prime_count(30)
+        self.assertTrue(cpp.prime_count_cache_clear(30))
+        self.assertFalse(cpp.prime_count_cache_clear(30))
+        self.assertEqual(cpp.prime_count_cache_info()[3], 0)
+
+    def test_eviction(self):
+        for n in range(100):
+            cpp.prime_count(n)
+        self.assertEqual(cpp.prime_count_cache_info()[3], 64)
+        self.assertEqual(cpp.prime_count(99), 25)
+        self.assertEqual(cpp.prime_count(0), 0)
+
+    def test_string_keys_are_contents(self):
+        hits = cpp.vowels_cache_info()[0]
+        # Built at run time, so each is a new object that may reuse the
+        # memory of the last one.
+        for i in range(50):
+            word = ''.join(['a'] * (i % 5) + ['x'])
+            self.assertEqual(cpp.vowels(word), i % 5)
+        self.assertEqual(cpp.vowels_cache_info()[0] - hits, 45)
+
+    def test_threads(self):
+        errors = []
+
+        def run():
+            try:
+                for n in range(2000):
+                    self.assertEqual(cpp.prime_count(n % 20),
+                                     cpp.prime_count(n % 20))
+                    if n % 100 == 0:
+                        cpp.prime_count_cache_info()
+                        cpp.prime_count_cache_clear(n % 20)
+            except Exception as e:
+                errors.append(e)
+
+        threads = [threading.Thread(target=run) for i in range(4)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        self.assertEqual(errors, [])
+        self.assertEqual(cpp.prime_count(19), 7)
+
+    def test_bad_arguments(self):
+        self.assertRaises(TypeError, cpp.prime_count, 'ten')
+        self.assertRaises(TypeError, cpp.prime_count)
+        self.assertRaises(TypeError, cpp.vowels, 5)
+
+
+if __name__ == '__main__':
+    unittest.main()
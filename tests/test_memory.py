@@ -0,0 +1,60 @@
+import gc
+import sys
+import unittest
+
+import support
+import cpp
+import vec
+
+
+def stats(name):
+    return cpp.type_stats().get(name, (0, 0, 0))
+
+
+class MemoryTest(unittest.TestCase):
+
+    def test_sizeof_counts_heap(self):
+        small = cpp.Ints([1])
+        big = cpp.Ints(list(range(10000)))
+        self.assertGreaterEqual(big.__sizeof__() - small.__sizeof__(),
+                                9999 * 4)
+
+    def test_live_and_bytes(self):
+        gc.collect()
+        live, created, bytes = stats('cpp.Ints')
+        xs = [cpp.Ints(list(range(n * 100))) for n in range(10)]
+        l2, c2, b2 = stats('cpp.Ints')
+        self.assertEqual(l2 - live, 10)
+        self.assertEqual(c2 - created, 10)
+        self.assertEqual(b2 - bytes, sum(x.__sizeof__() for x in xs))
+
+        del xs
+        gc.collect()
+        self.assertEqual(stats('cpp.Ints'), (live, c2, bytes))
+
+    def test_custom_new_balances(self):
+        # KDTree has its own tp_new and the default dealloc.
+        live, created, bytes = stats('vec.KDTree')
+        trees = [vec.KDTree([vec.Vec(i, 0, 0)] * i) for i in range(5)]
+        l2, c2, b2 = stats('vec.KDTree')
+        self.assertEqual(l2 - live, 5)
+        self.assertEqual(b2 - bytes, sum(t.__sizeof__() for t in trees))
+
+        del trees
+        self.assertEqual(stats('vec.KDTree')[0], live)
+        self.assertRaises(TypeError, vec.KDTree, 5)
+        self.assertEqual(stats('vec.KDTree'), (live, c2, bytes))
+
+    def test_never_negative(self):
+        for i in range(3):
+            vec.Vec(1, 2, 3) + vec.Vec(1, 1, 1)
+            vec.Vec4(1, 2, 3, 4)
+            cpp.Ints([1, 2])
+        for name, (live, created, bytes) in cpp.type_stats().items():
+            self.assertGreaterEqual(live, 0, name)
+            self.assertGreaterEqual(created, live, name)
+            self.assertGreaterEqual(bytes, 0, name)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,47 @@
+import unittest
+
+import support
+import vec
+
+
+class NumberTest(unittest.TestCase):
+
+    def setUp(self):
+        self.a = vec.Vec(1, 2, 3)
+        self.b = vec.Vec(4, 5, 6)
+
+    def test_operators(self):
+        support.assertVec(self, self.a + self.b, 5, 7, 9)
+        support.assertVec(self, self.b - self.a, 3, 3, 3)
+        support.assertVec(self, -self.a, -1, -2, -3)
+        support.assertVec(self, self.a ^ self.b, -3, 6, -3)
+        self.assertEqual(self.a * self.b, 32.0)
+
+    def test_inplace(self):
+        a = vec.Vec(1, 2, 3)
+        alias = a
+        a += self.b
+        self.assertIs(a, alias)
+        support.assertVec(self, a, 5, 7, 9)
+
+    def test_mixed_operands_raise(self):
+        a = self.a
+        self.assertRaises(TypeError, lambda: a + 1)
+        self.assertRaises(TypeError, lambda: 1 - a)
+        self.assertRaises(TypeError, lambda: a * 'abc')
+        self.assertRaises(TypeError, lambda: 'abc' * a)
+        self.assertRaises(TypeError, lambda: a ^ None)
+
+        def iadd():
+            v = vec.Vec(1, 2, 3)
+            v += 1
+        self.assertRaises(TypeError, iadd)
+
+    def test_defers_to_other_operand(self):
+        lazy = self.a + vec.lazy(self.b)
+        self.assertIsInstance(lazy, vec.LazyVec)
+        support.assertVec(self, lazy.eval(), 5, 7, 9)
+
+
+if __name__ == '__main__':
+    unittest.main()
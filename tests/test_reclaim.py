@@ -0,0 +1,77 @@
+import os
+import time
+import unittest
+import warnings
+
+import support
+import cpp
+
+# Over ReclaimAbove<16 MiB> for Ints.
+BIG = 5 * 1000 * 1000
+
+
+def live_ints():
+    return cpp.type_stats().get('cpp.Ints', (0, 0, 0))[0]
+
+
+class ReclaimTest(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        cls.values = list(range(BIG))
+
+    def test_big_value_freed(self):
+        live = live_ints()
+        x = cpp.Ints(self.values)
+        self.assertEqual(live_ints(), live + 1)
+        del x
+        # The object is gone at once; only its vector waits for the thread.
+        self.assertEqual(live_ints(), live)
+        cpp.reclaim_wait()
+
+    def test_many(self):
+        for i in range(3):
+            x = cpp.Ints(self.values)
+            self.assertEqual(len(x.filter(lambda v: v == 7)), 1)
+            del x
+        small = [cpp.Ints([1, 2, 3]) for i in range(100)]
+        del small
+        cpp.reclaim_wait()
+        cpp.reclaim_wait()
+
+    @unittest.skipUnless(hasattr(os, 'fork'), 'needs fork')
+    def test_after_fork(self):
+        # Make sure the parent's worker exists before forking.
+        x = cpp.Ints(self.values)
+        del x
+        cpp.reclaim_wait()
+
+        with warnings.catch_warnings():
+            warnings.simplefilter('ignore')
+            pid = os.fork()
+        if pid == 0:
+            code = 1
+            try:
+                y = cpp.Ints(self.values)
+                del y
+                cpp.reclaim_wait()
+                code = 0
+            finally:
+                os._exit(code)
+
+        deadline = time.time() + 60
+        while True:
+            done, status = os.waitpid(pid, os.WNOHANG)
+            if done:
+                break
+            if time.time() > deadline:
+                os.kill(pid, 9)
+                os.waitpid(pid, 0)
+                self.fail('the child hung waiting on the reclaimer')
+            time.sleep(0.01)
+        self.assertTrue(os.WIFEXITED(status))
+        self.assertEqual(os.WEXITSTATUS(status), 0)
+
+
+if __name__ == '__main__':
+    unittest.main()
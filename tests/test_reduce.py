@@ -0,0 +1,76 @@
+import math
+import random
+import unittest
+
+import support
+import vec
+
+
+class ReduceTest(unittest.TestCase):
+
+    def setUp(self):
+        rng = random.Random(37)
+        self.vecs = [vec.Vec(rng.uniform(-10, 10), rng.uniform(-10, 10),
+                             rng.uniform(-10, 10)) for i in range(20000)]
+        self.pts = [(v.x, v.y, v.z) for v in self.vecs]
+
+    def test_sum(self):
+        expect = [math.fsum(p[i] for p in self.pts) for i in range(3)]
+        support.assertVec(self, vec.sum(self.vecs, True), *expect, places=2)
+        support.assertVec(self, vec.sum(self.vecs), *expect, places=0)
+        support.assertVec(self, vec.sum([]), 0, 0, 0)
+
+    def test_sum_is_deterministic(self):
+        first = vec.sum(self.vecs)
+        for i in range(5):
+            again = vec.sum(self.vecs)
+            self.assertEqual((again.x, again.y, again.z),
+                             (first.x, first.y, first.z))
+
+    def test_centroid_and_bounds(self):
+        ps = [vec.Vec(1, 2, 3), vec.Vec(-1, 0, 4)]
+        support.assertVec(self, vec.centroid(ps), 0, 1, 3.5)
+        lo, hi = vec.bounds(ps)
+        support.assertVec(self, lo, -1, 0, 3)
+        support.assertVec(self, hi, 1, 2, 4)
+
+        lo, hi = vec.bounds(self.vecs)
+        support.assertVec(self, lo, *[min(p[i] for p in self.pts)
+                                      for i in range(3)])
+        support.assertVec(self, hi, *[max(p[i] for p in self.pts)
+                                      for i in range(3)])
+
+    def test_lengths(self):
+        out = vec.lengths(self.vecs[:100])
+        self.assertEqual(len(out), 100)
+        for i in range(100):
+            self.assertAlmostEqual(out[i], math.sqrt(sum(
+                c * c for c in self.pts[i])), places=4)
+
+    def test_transform(self):
+        ps = [vec.Vec(1, 2, 3), vec.Vec(-1, 0, 4)]
+        swap = [vec.Vec(0, 1, 0), vec.Vec(1, 0, 0), vec.Vec(0, 0, 1)]
+        out = vec.transform(ps, swap, vec.Vec(1, 1, 1))
+        self.assertEqual(len(out), 2)
+        support.assertVec(self, out[0], 3, 2, 4)
+        support.assertVec(self, out[1], 1, 0, 5)
+
+    def test_rotate(self):
+        ps = [vec.Vec(1, 2, 3), vec.Vec(-1, 0, 4)]
+        # Half a turn about z, given unnormalized.
+        out = vec.rotate(ps, (0, 0, 0, 2))
+        support.assertVec(self, out[0], -1, -2, 3)
+        support.assertVec(self, out[1], 1, 0, 4)
+
+    def test_errors(self):
+        ps = [vec.Vec(1, 2, 3)]
+        self.assertRaises(ValueError, vec.centroid, [])
+        self.assertRaises(ValueError, vec.bounds, [])
+        self.assertRaises(TypeError, vec.sum, [1])
+        self.assertRaises(ValueError, vec.transform, ps, [vec.Vec(1, 0, 0)])
+        self.assertRaises(TypeError, vec.rotate, ps, (1, 0, 0))
+        self.assertRaises(ValueError, vec.rotate, ps, (0, 0, 0, 0))
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,56 @@
+import random
+import sys
+import unittest
+
+import support
+import cpp
+
+
+class SortTest(unittest.TestCase):
+
+    def setUp(self):
+        self.rng = random.Random(34)
+
+    def check(self, xs, key=None):
+        expect = sorted(xs, key=key)
+        got = cpp.sorted(xs, key) if key else cpp.sorted(xs)
+        self.assertEqual(got, expect)
+        self.assertEqual([type(x) for x in got], [type(x) for x in expect])
+
+    def test_ints(self):
+        self.check([self.rng.randint(-10**6, 10**6) for i in range(1000)])
+        self.check([2**70, -2**65, 3, 0])
+
+    def test_floats(self):
+        self.check([self.rng.uniform(-1, 1) for i in range(1000)])
+        self.check([1.5, -0.0, 0.0, float('inf'), -float('inf')])
+
+    def test_strs(self):
+        words = [''.join(self.rng.choice('abcxyz') for j in range(5))
+                 for i in range(500)]
+        self.check(words)
+
+    def test_mixed_numbers(self):
+        self.check([1, 2.5, 0, -3.25, True])
+
+    def test_key_is_stable(self):
+        self.check([(i % 7, i) for i in range(100)], key=lambda p: p[0])
+        self.check([3, -1, 2, -3, 1], key=abs)
+
+    def test_any_iterable(self):
+        self.assertEqual(cpp.sorted((3, 1, 2)), [1, 2, 3])
+        self.assertEqual(cpp.sorted(iter([2, 1])), [1, 2])
+        self.assertEqual(cpp.sorted([]), [])
+
+    def test_errors(self):
+        self.assertRaises(TypeError, cpp.sorted, 5)
+        if sys.version_info[0] >= 3:
+            self.assertRaises(TypeError, cpp.sorted, [1, 'a', 2])
+        else:
+            self.check([1, 'a', 2])
+        self.assertRaises(ZeroDivisionError, cpp.sorted, [1, 0],
+                          lambda x: 1 // x)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,102 @@
+import json
+import threading
+import time
+import unittest
+
+import support
+import traced
+
+
+def rings(trace):
+    return len([e for e in json.loads(trace)['traceEvents']
+                if e['ph'] == 'M'])
+
+
+def events(trace):
+    # The trace_* calls are traced too; leave them out.
+    return [e for e in json.loads(trace)['traceEvents']
+            if e['ph'] != 'M' and not e['name'].startswith('trace_')]
+
+
+class TraceTest(unittest.TestCase):
+
+    def tearDown(self):
+        traced.trace_stop(True)
+
+    def test_calls(self):
+        traced.trace_stop(True)
+        traced.trace_start()
+        traced.work(10)
+        traced.trace_stop()
+        names = [(e['name'], e['ph']) for e in events(traced.trace_dump())]
+        self.assertIn(('work', 'B'), names)
+        self.assertIn(('work', 'E'), names)
+        self.assertLess(names.index(('work', 'B')), names.index(('work', 'E')))
+
+    def test_stop_clear(self):
+        traced.trace_start()
+        traced.work(1)
+        traced.trace_stop(True)
+        self.assertEqual(events(traced.trace_dump()), [])
+        traced.work(1)
+        self.assertEqual(events(traced.trace_dump()), [])
+
+    def churn(self, n, dump=False):
+        for i in range(n):
+            t = threading.Thread(target=traced.work, args=(0,))
+            t.start()
+            t.join()
+            if dump:
+                traced.trace_dump()
+
+    def test_exited_threads_reuse_rings(self):
+        traced.trace_start()
+        self.churn(10, dump=True)
+        before = rings(traced.trace_dump())
+        self.churn(100, dump=True)
+        self.assertLessEqual(rings(traced.trace_dump()), before + 1)
+
+    def test_rings_bounded_without_dumps(self):
+        traced.trace_start()
+        self.churn(10)
+        before = rings(traced.trace_dump())
+        self.churn(100)
+        # Past a few undumped exited threads, the oldest rings are reused.
+        self.assertLessEqual(rings(traced.trace_dump()), before + 20)
+        names = set(e['name'] for e in events(traced.trace_dump()))
+        self.assertIn('work', names)
+
+    def test_dump_and_clear_while_recording(self):
+        stop = threading.Event()
+
+        def run():
+            while not stop.is_set():
+                traced.work(20)
+
+        traced.trace_start()
+        threads = [threading.Thread(target=run) for i in range(4)]
+        for t in threads:
+            t.start()
+        try:
+            seen = 0
+            deadline = time.time() + 0.5
+            while time.time() < deadline:
+                for e in events(traced.trace_dump()):
+                    self.assertIn(e['ph'], ('B', 'E'))
+                    self.assertIn(e['name'], ('work', 'nogil', 'wait'))
+                    seen += 1
+                if seen % 3 == 0:
+                    traced.trace_stop(True)
+                    traced.trace_start()
+                time.sleep(0.001)
+            self.assertGreater(seen, 0)
+        finally:
+            stop.set()
+            for t in threads:
+                t.join()
+        traced.trace_stop(True)
+        self.assertEqual(events(traced.trace_dump()), [])
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,49 @@
+import array
+import sys
+import unittest
+
+import support
+import vec
+
+
+@unittest.skipIf(sys.version_info[0] < 3,
+                 'array.array has no new-style buffer on Python 2')
+class VectorizeTest(unittest.TestCase):
+
+    def test_norms(self):
+        xs = array.array('f', [3, 0, 1])
+        ys = array.array('f', [4, 0, 2])
+        zs = array.array('f', [0, 5, 2])
+        out = vec.norms(xs, ys, zs)
+        self.assertEqual(len(out), 3)
+        self.assertEqual(memoryview(out).tolist(), [5.0, 5.0, 3.0])
+
+    def test_broadcast_and_out(self):
+        xs = array.array('f', [3, 6])
+        out = array.array('f', [0, 0])
+        vec.norms(xs, 4.0, 0.0, out=out)
+        self.assertEqual(list(out), [5.0, 7.2111024856567383])
+
+    def test_strided(self):
+        xs = memoryview(array.array('f', [3, -1, 0, -1])).cast('B').cast('f')
+        out = vec.norms(xs[::2], 4.0, 0.0)
+        self.assertEqual(memoryview(out).tolist(), [5.0, 4.0])
+
+    def test_large(self):
+        n = 100000
+        xs = array.array('f', [3]) * n
+        out = vec.norms(xs, 4.0, 0.0)
+        self.assertEqual(len(out), n)
+        self.assertEqual(out[n - 1], 5.0)
+
+    def test_errors(self):
+        xs = array.array('f', [3, 0])
+        self.assertRaises(ValueError, vec.norms, xs, array.array('f', [1]),
+                          xs)
+        self.assertRaises(TypeError, vec.norms, array.array('d', [1]), 1, 1)
+        self.assertRaises(TypeError, vec.norms, xs, 'y', xs)
+        self.assertRaises(TypeError, vec.norms, xs, xs)
+
+
+if __name__ == '__main__':
+    unittest.main()